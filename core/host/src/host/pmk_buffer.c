@@ -1,32 +1,153 @@
 #include "../premake_internal.h"
+#include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "premake.h"
 
+/* Smallest allocation made once a buffer is first written */
+#define PMK_BUFFER_MIN_CAPACITY  (4096)
+
+/* Capacity of a streaming buffer, if no other chunk size is requested */
+#define PMK_BUFFER_STREAM_CHUNK  (64 * 1024)
+
 struct pmk_Buffer
 {
 	size_t capacity;
 	size_t length;
 	char*  data;
+
+	/* Line formatting state, used by the indented and line-oriented writes */
+	char*  eol;
+	size_t eolLength;
+	char*  indentString;
+	size_t indentStringLength;
+	size_t indentLevel;
+
+	/* The indent string repeated `prefixLevel` times; any shallower indent is a slice of it */
+	char*  prefix;
+	size_t prefixLevel;
+
+	/* If set, full chunks are flushed to this stream instead of growing the buffer */
+	pmk_Stream* stream;
 };
 
 
+/**
+ * Grow the buffer geometrically until it can hold at least `required` bytes.
+ */
+static int grow(pmk_Buffer* b, size_t required)
+{
+	size_t cap = b->capacity;
+	if (cap < PMK_BUFFER_MIN_CAPACITY)
+		cap = PMK_BUFFER_MIN_CAPACITY;
+
+	while (cap < required)
+		cap += cap / 2;
+
+	return (pmk_bufferReserve(b, cap));
+}
+
+
+/**
+ * Number of trailing end-of-line bytes in the buffer; these are trimmed from the
+ * final output, so they are held back until it is known that more text follows.
+ */
+static size_t trailingEolLength(pmk_Buffer* b)
+{
+	size_t n = 0;
+	if (b->length > n && b->data[b->length - n - 1] == '\n')
+		++n;
+	if (b->length > n && b->data[b->length - n - 1] == '\r')
+		++n;
+	return (n);
+}
+
+
+/**
+ * Pass everything but a possible trailing end-of-line on to the attached stream,
+ * freeing up the buffer for more output. Write failures are recorded by the stream
+ * and reported when it is finished.
+ */
+static void flush(pmk_Buffer* b)
+{
+	size_t held = trailingEolLength(b);
+	size_t len = b->length - held;
+
+	if (len > 0) {
+		pmk_streamWrite(b->stream, b->data, len);
+		memmove(b->data, b->data + len, held);
+		b->length = held;
+	}
+}
+
+
+/**
+ * Replace one of the buffer's owned strings with a copy of `value`.
+ */
+static int setString(char** target, size_t* targetLength, const char* value, size_t len)
+{
+	char* copy = (char*)malloc(len + 1);
+	if (copy == NULL)
+		return (FALSE);
+
+	memcpy(copy, value, len);
+	copy[len] = '\0';
+
+	free(*target);
+	*target = copy;
+	*targetLength = len;
+	return (TRUE);
+}
+
+
+/**
+ * Create a new, empty buffer.
+ *
+ * @returns
+ *    The new buffer, or `NULL` if the memory could not be allocated.
+ */
 pmk_Buffer* pmk_bufferInit()
 {
 	pmk_Buffer* b = (pmk_Buffer*)malloc(sizeof(struct pmk_Buffer));
+	if (b == NULL)
+		return (NULL);
+
 	b->capacity = 0;
 	b->length = 0;
 	b->data = NULL;
+
+	b->eol = NULL;
+	b->indentString = NULL;
+	b->indentLevel = 0;
+
+	b->prefix = NULL;
+	b->prefixLevel = 0;
+
+	b->stream = NULL;
+
+	if (!setString(&b->eol, &b->eolLength, "\n", 1) ||
+		!setString(&b->indentString, &b->indentStringLength, "\t", 1))
+	{
+		pmk_bufferClose(b);
+		return (NULL);
+	}
+
 	return (b);
 }
 
 
 void pmk_bufferClose(pmk_Buffer* b)
 {
+	if (b->stream != NULL)
+		pmk_streamAbort(b->stream);
 	free(b->data);
 	b->capacity = 0;
 	b->length = 0;
 	b->data = NULL;
+	free(b->eol);
+	free(b->indentString);
+	free(b->prefix);
 	free(b);
 }
 
@@ -37,49 +158,274 @@ const char* pmk_bufferContents(pmk_Buffer* b)
 }
 
 
+/**
+ * Copy the line formatting state (end-of-line sequence, indent string, and indent
+ * level) from one buffer to another. Used to let nested captures pick up where the
+ * enclosing capture left off.
+ */
+int pmk_bufferCopyFormat(pmk_Buffer* b, const pmk_Buffer* source)
+{
+	if (!setString(&b->eol, &b->eolLength, source->eol, source->eolLength))
+		return (FALSE);
+
+	if (!pmk_bufferSetIndentString(b, source->indentString, source->indentStringLength))
+		return (FALSE);
+
+	b->indentLevel = source->indentLevel;
+	return (TRUE);
+}
+
+
+const char* pmk_bufferEol(pmk_Buffer* b, size_t* len)
+{
+	*len = b->eolLength;
+	return (b->eol);
+}
+
+
+/**
+ * Adjust the indent level by `amount`, which may be negative. The level never drops
+ * below zero.
+ */
+void pmk_bufferIndent(pmk_Buffer* b, long amount)
+{
+	if (amount < 0 && (size_t)(-amount) > b->indentLevel)
+		b->indentLevel = 0;
+	else
+		b->indentLevel += amount;
+}
+
+
+size_t pmk_bufferIndentLevel(pmk_Buffer* b)
+{
+	return (b->indentLevel);
+}
+
+
+const char* pmk_bufferIndentString(pmk_Buffer* b, size_t* len)
+{
+	*len = b->indentStringLength;
+	return (b->indentString);
+}
+
+
 size_t pmk_bufferLen(pmk_Buffer* b)
 {
 	return (b->length);
 }
 
 
-void pmk_bufferPuts(pmk_Buffer* b, const char* ptr, size_t len)
+/**
+ * Discard the buffer's contents, keeping its memory and formatting for reuse.
+ */
+void pmk_bufferReset(pmk_Buffer* b)
+{
+	if (b->stream != NULL) {
+		pmk_streamAbort(b->stream);
+		b->stream = NULL;
+	}
+	b->length = 0;
+}
+
+
+int pmk_bufferSetEol(pmk_Buffer* b, const char* value, size_t len)
 {
-	char* data;
+	return (setString(&b->eol, &b->eolLength, value, len));
+}
 
-	size_t required = b->length + len;
-	if (required > b->capacity)
+
+int pmk_bufferSetIndentString(pmk_Buffer* b, const char* value, size_t len)
+{
+	if (!setString(&b->indentString, &b->indentStringLength, value, len))
+		return (FALSE);
+
+	b->prefixLevel = 0;
+	return (TRUE);
+}
+
+
+/**
+ * Ensure the buffer has room for at least `capacity` bytes in total, without
+ * any further allocations. Existing contents are preserved.
+ *
+ * @returns
+ *    `TRUE` if the buffer has the requested capacity, `FALSE` if the memory
+ *    could not be allocated.
+ */
+int pmk_bufferReserve(pmk_Buffer* b, size_t capacity)
+{
+	if (capacity > b->capacity)
 	{
-		size_t cap = b->capacity;
-		while (required > cap)
-		{
-			cap = (cap * 3) / 2;
-			if (cap <= 65536)
-				cap = 65536;
-		}
+		char* data = (char*)realloc(b->data, capacity);
+		if (data == NULL)
+			return (FALSE);
 
-		data = (char*)calloc(cap, 1);
-		if (b->length > 0)
-		{
-			memcpy(data, b->data, b->length);
-			free(b->data);
-		}
 		b->data = data;
-		b->capacity = cap;
+		b->capacity = capacity;
 	}
 
+	return (TRUE);
+}
+
+
+int pmk_bufferPuts(pmk_Buffer* b, const char* ptr, size_t len)
+{
+	if (b->length + len > b->capacity && b->stream != NULL)
+		flush(b);
+
+	size_t required = b->length + len;
+	if (required > b->capacity && !grow(b, required))
+		return (FALSE);
+
 	memcpy(b->data + b->length, ptr, len);
 	b->length += len;
+	return (TRUE);
 }
 
 
-void pmk_bufferPrintf(pmk_Buffer* b, const char *fmt, ...)
+/**
+ * Write the current end-of-line sequence.
+ */
+int pmk_bufferPutEol(pmk_Buffer* b)
+{
+	return (pmk_bufferPuts(b, b->eol, b->eolLength));
+}
+
+
+/**
+ * Write the indent string, repeated once per indent level. The repeated string is
+ * cached, so writing an indent costs a single copy.
+ */
+int pmk_bufferPutIndent(pmk_Buffer* b)
+{
+	size_t width = b->indentStringLength;
+	if (b->indentLevel == 0 || width == 0)
+		return (TRUE);
+
+	if (b->indentLevel > b->prefixLevel)
+	{
+		char* prefix = (char*)realloc(b->prefix, b->indentLevel * width);
+		if (prefix == NULL)
+			return (FALSE);
+
+		for (size_t i = b->prefixLevel; i < b->indentLevel; ++i)
+			memcpy(prefix + i * width, b->indentString, width);
+
+		b->prefix = prefix;
+		b->prefixLevel = b->indentLevel;
+	}
+
+	return (pmk_bufferPuts(b, b->prefix, b->indentLevel * width));
+}
+
+
+int pmk_bufferPrintf(pmk_Buffer* b, const char *fmt, ...)
 {
-	char text[2048];
-	int len;
 	va_list args;
 	va_start(args, fmt);
-	len = vsnprintf(text, sizeof(text) - 1, fmt, args);
+	int result = pmk_bufferPrintfv(b, fmt, args);
 	va_end(args);
-	pmk_bufferPuts(b, text, len);
+	return (result);
+}
+
+
+int pmk_bufferPrintfv(pmk_Buffer* b, const char *fmt, va_list args)
+{
+	va_list argsCopy;
+
+	/* Try to format directly into the available space first */
+	size_t available = b->capacity - b->length;
+	char* target = (available > 0) ? b->data + b->length : NULL;
+
+	va_copy(argsCopy, args);
+	int len = vsnprintf(target, available, fmt, argsCopy);
+	va_end(argsCopy);
+
+	if (len < 0)
+		return (FALSE);
+
+	/* Didn't fit; make room for the full result (and the terminator) and go again */
+	if ((size_t)len >= available) {
+		if (b->stream != NULL)
+			flush(b);
+		if (b->length + len + 1 > b->capacity && !grow(b, b->length + len + 1))
+			return (FALSE);
+		vsnprintf(b->data + b->length, len + 1, fmt, args);
+	}
+
+	b->length += len;
+	return (TRUE);
+}
+
+
+/**
+ * Send the buffer's output to a file instead of holding it in memory. The buffer's
+ * capacity is set to `chunkSize`: whenever a write would overflow it, the pending
+ * output is handed to the stream. Any contents already in the buffer are kept.
+ *
+ * A reused buffer may have grown well past the chunk size during an earlier capture;
+ * it is shrunk back down, so memory use stays bounded by the chunk size.
+ *
+ * @returns
+ *    `TRUE` if the stream was opened, `FALSE` otherwise.
+ */
+int pmk_bufferStream(pmk_Buffer* b, const char* path, size_t chunkSize)
+{
+	pmk_Stream* stream = pmk_streamOpen(path);
+	if (stream == NULL)
+		return (FALSE);
+
+	if (b->stream != NULL)
+		pmk_streamAbort(b->stream);
+
+	b->stream = stream;
+
+	if (chunkSize == 0)
+		chunkSize = PMK_BUFFER_STREAM_CHUNK;
+
+	if (b->capacity > chunkSize)
+	{
+		if (b->length > chunkSize)
+			flush(b);
+
+		size_t capacity = (b->length > chunkSize) ? b->length : chunkSize;
+		char* data = (char*)realloc(b->data, capacity);
+		if (data != NULL) {
+			b->data = data;
+			b->capacity = capacity;
+		}
+	}
+	else if (!pmk_bufferReserve(b, chunkSize))
+	{
+		pmk_streamAbort(b->stream);
+		b->stream = NULL;
+		return (FALSE);
+	}
+
+	return (TRUE);
+}
+
+
+int pmk_bufferIsStreaming(pmk_Buffer* b)
+{
+	return (b->stream != NULL);
+}
+
+
+/**
+ * Flush the remaining output, minus any trailing end-of-line, and close the
+ * attached stream. The buffer is left empty and ready for reuse.
+ *
+ * @returns
+ *    1 if the file was updated, 0 if it already held the same output, -1 on error.
+ */
+int pmk_bufferFinishStream(pmk_Buffer* b)
+{
+	pmk_Stream* stream = b->stream;
+	b->stream = NULL;
+
+	pmk_streamWrite(stream, b->data, b->length - trailingEolLength(b));
+	b->length = 0;
+
+	return (pmk_streamClose(stream));
 }
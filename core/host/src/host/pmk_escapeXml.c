@@ -2,60 +2,117 @@
 
 #include <string.h>
 
+/* Use SSE2 to scan sixteen bytes at a time when it is available; it is part of the
+ * baseline for all x86-64 targets. Other platforms fall back to a table lookup. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PMK_XML_USE_SSE2 (1)
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
 
-static int appendChar(char* result, int index, char value)
+
+/* Characters which must be escaped in XML content and attribute values */
+static const unsigned char isSpecial[256] = {
+	['&'] = 1,
+	['<'] = 1,
+	['>'] = 1,
+	['"'] = 1
+};
+
+
+#if PMK_XML_USE_SSE2
+static int indexOfLowestBit(int mask)
 {
-	if ((index + 1) < (PATH_MAX - 1)) {
-		result[index] = value;
-		return (1);
-	} else {
-		return (0);
-	}
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, (unsigned long)mask);
+	return ((int)index);
+#else
+	return (__builtin_ctz((unsigned int)mask));
+#endif
 }
+#endif
 
 
-static int appendStr(char* result, int index, const char* value)
+/**
+ * Scan a string for characters which would need to be escaped in an XML document.
+ *
+ * @param value
+ *    The string to scan; may contain embedded zeros.
+ * @param len
+ *    The length of the string, in bytes.
+ * @returns
+ *    The index of the first character requiring escaping, or `len` if none do.
+ */
+size_t pmk_findXmlSpecial(const char* value, size_t len)
 {
-	int len = strlen(value);
-	if ((index + len) < (PATH_MAX - 1)) {
-		strcpy(result + index, value);
-		return (len);
-	} else {
-		return (0);
+	size_t i = 0;
+
+#if PMK_XML_USE_SSE2
+	const __m128i amp = _mm_set1_epi8('&');
+	const __m128i lt = _mm_set1_epi8('<');
+	const __m128i gt = _mm_set1_epi8('>');
+	const __m128i quot = _mm_set1_epi8('"');
+
+	for (; i + 16 <= len; i += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*)(value + i));
+		__m128i matches = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, lt)),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, gt), _mm_cmpeq_epi8(chunk, quot)));
+
+		int mask = _mm_movemask_epi8(matches);
+		if (mask != 0) {
+			return (i + indexOfLowestBit(mask));
+		}
+	}
+#endif
+
+	for (; i < len; ++i) {
+		if (isSpecial[(unsigned char)value[i]]) {
+			return (i);
+		}
 	}
+
+	return (len);
 }
 
 
-void pmk_escapeXml(char* result, const char* value)
+/**
+ * Append an XML-escaped copy of a string to a Lua string buffer.
+ */
+void pmk_escapeXml(luaL_Buffer* b, const char* value, size_t len)
 {
-	int i = 0;
+	size_t start = 0;
 
-	while (*value != '\0') {
-		switch (*value)
+	while (start < len) {
+		size_t i = start + pmk_findXmlSpecial(value + start, len - start);
+
+		/* copy everything up to the special character in one go */
+		luaL_addlstring(b, value + start, i - start);
+		if (i == len)
+			break;
+
+		switch (value[i])
 		{
 		case '&':
-			i += appendStr(result, i, "&amp;");
+			luaL_addlstring(b, "&amp;", 5);
 			break;
 
 		case '<':
-			i += appendStr(result, i, "&lt;");
+			luaL_addlstring(b, "&lt;", 4);
 			break;
 
 		case '>':
-			i += appendStr(result, i, "&gt;");
+			luaL_addlstring(b, "&gt;", 4);
 			break;
 
 		case '"':
-			i += appendStr(result, i, "&quot;");
-			break;
-
-		default:
-			i += appendChar(result, i, *value);
+			luaL_addlstring(b, "&quot;", 6);
 			break;
 		}
 
-		++value;
+		start = i + 1;
 	}
-
-	result[i] = '\0';
 }
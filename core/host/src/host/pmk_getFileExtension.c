@@ -0,0 +1,18 @@
+#include "../premake_internal.h"
+
+#include <string.h>
+
+int pmk_getFileExtension(char* result, const char* path)
+{
+	pmk_getFileName(result, path);
+
+	/* Extension begins at the last '.' in the file name, if any */
+	char* startPtr = strrchr(result, '.');
+	if (startPtr != NULL) {
+		memmove(result, startPtr, strlen(startPtr) + 1);
+	} else {
+		result[0] = '\0';
+	}
+
+	return (TRUE);
+}
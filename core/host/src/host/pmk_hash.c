@@ -19,3 +19,60 @@ uint32_t pmk_hash(const char* value, int seed)
 
 	return hash;
 }
+
+
+uint64_t pmk_hash64(const void* data, size_t len, uint64_t seed)
+{
+	/* MurmurHash64A; consumes eight bytes per step rather than one. Byte order is
+	 * platform dependent, so don't persist these values across machines. */
+
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	const int r = 47;
+
+	const unsigned char* ptr = (const unsigned char*)data;
+	const unsigned char* end = ptr + (len & ~(size_t)7);
+
+	uint64_t hash = seed ^ (len * m);
+
+	while (ptr != end) {
+		uint64_t k;
+		memcpy(&k, ptr, sizeof(k));
+		ptr += 8;
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		hash ^= k;
+		hash *= m;
+	}
+
+	switch (len & 7) {
+	case 7: hash ^= (uint64_t)ptr[6] << 48; /* fall through */
+	case 6: hash ^= (uint64_t)ptr[5] << 40; /* fall through */
+	case 5: hash ^= (uint64_t)ptr[4] << 32; /* fall through */
+	case 4: hash ^= (uint64_t)ptr[3] << 24; /* fall through */
+	case 3: hash ^= (uint64_t)ptr[2] << 16; /* fall through */
+	case 2: hash ^= (uint64_t)ptr[1] << 8;  /* fall through */
+	case 1: hash ^= (uint64_t)ptr[0];
+		hash *= m;
+	}
+
+	hash ^= hash >> r;
+	hash *= m;
+	hash ^= hash >> r;
+
+	return hash;
+}
+
+
+uint64_t pmk_hashMix(uint64_t value)
+{
+	/* SplitMix64 finalizer */
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ULL;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebULL;
+	value ^= value >> 31;
+	return value;
+}
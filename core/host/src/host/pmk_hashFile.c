@@ -0,0 +1,49 @@
+#include "../premake_internal.h"
+
+#include <stdio.h>
+
+#define HASH_CHUNK_SIZE  (64 * 1024)
+
+
+/**
+ * Compute a 64-bit hash of a file's contents, reading it a chunk at a time so
+ * large files don't need to be held in memory.
+ *
+ * @param path
+ *    The file to be hashed.
+ * @param result
+ *    Receives the hash value.
+ * @returns
+ *    `OKAY` on success, or -1 if the file could not be read.
+ */
+int pmk_hashFile(const char* path, uint64_t* result)
+{
+	char* chunk;
+	size_t numBytesRead;
+	uint64_t hash = 0;
+
+	FILE* file = pmk_openFile(path, "rb");
+	if (file == NULL)
+		return (-1);
+
+	chunk = (char*)malloc(HASH_CHUNK_SIZE);
+	if (chunk == NULL) {
+		fclose(file);
+		return (-1);
+	}
+
+	do {
+		numBytesRead = fread(chunk, 1, HASH_CHUNK_SIZE, file);
+		hash = pmk_hashMix(hash ^ pmk_hash64(chunk, numBytesRead, hash));
+	} while (numBytesRead == HASH_CHUNK_SIZE);
+
+	int failed = ferror(file);
+	free(chunk);
+	fclose(file);
+
+	if (failed)
+		return (-1);
+
+	*result = hash;
+	return (OKAY);
+}
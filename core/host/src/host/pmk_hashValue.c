@@ -0,0 +1,113 @@
+#include "../premake_internal.h"
+
+#include <math.h>
+#include <string.h>
+
+#define HASH_MAX_DEPTH  (64)
+
+/* Distinguish values of different types which might otherwise hash the same */
+#define TAG_NIL      (0x6e696c0000000001ULL)
+#define TAG_BOOLEAN  (0x626f6f6c00000002ULL)
+#define TAG_INTEGER  (0x696e740000000003ULL)
+#define TAG_FLOAT    (0x666c6f6174000004ULL)
+#define TAG_STRING   (0x7374720000000005ULL)
+#define TAG_TABLE    (0x7461626c65000006ULL)
+#define TAG_CYCLE    (0x6379636c65000007ULL)
+#define TAG_OTHER    (0x6f74686572000008ULL)
+
+typedef struct HashState {
+	const void* path[HASH_MAX_DEPTH];
+	int depth;
+} HashState;
+
+
+static uint64_t hashValue(lua_State* L, int index, HashState* hs);
+
+
+static uint64_t hashTable(lua_State* L, int index, HashState* hs)
+{
+	const void* ptr = lua_topointer(L, index);
+
+	/* A table which contains itself hashes to a constant at the point of recursion */
+	for (int i = 0; i < hs->depth; ++i) {
+		if (hs->path[i] == ptr)
+			return (pmk_hashMix(TAG_CYCLE));
+	}
+
+	if (hs->depth == HASH_MAX_DEPTH) {
+		luaL_error(L, "table is too deeply nested to hash");
+	}
+
+	luaL_checkstack(L, 3, "table is too deeply nested to hash");
+	hs->path[hs->depth++] = ptr;
+
+	/* Combine the key-value pairs with addition so the result doesn't depend on
+	 * the order in which `lua_next()` happens to visit them */
+	uint64_t sum = 0;
+	uint64_t count = 0;
+
+	lua_pushnil(L);
+	while (lua_next(L, index) != 0) {
+		int top = lua_gettop(L);
+		uint64_t keyHash = hashValue(L, top - 1, hs);
+		uint64_t valueHash = hashValue(L, top, hs);
+		sum += pmk_hashMix(keyHash * 31 + pmk_hashMix(valueHash));
+		++count;
+		lua_pop(L, 1);
+	}
+
+	--hs->depth;
+	return (pmk_hashMix(sum ^ pmk_hashMix(TAG_TABLE + count)));
+}
+
+
+static uint64_t hashValue(lua_State* L, int index, HashState* hs)
+{
+	switch (lua_type(L, index))
+	{
+	case LUA_TNIL:
+		return (pmk_hashMix(TAG_NIL));
+
+	case LUA_TBOOLEAN:
+		return (pmk_hashMix(TAG_BOOLEAN + lua_toboolean(L, index)));
+
+	case LUA_TNUMBER:
+		if (lua_isinteger(L, index)) {
+			return (pmk_hashMix(TAG_INTEGER ^ (uint64_t)lua_tointeger(L, index)));
+		} else {
+			/* floats with integral values must hash the same as the integer, as they do in a Lua table */
+			lua_Number n = lua_tonumber(L, index);
+			if (n == floor(n) && n >= -9223372036854775808.0 && n < 9223372036854775808.0) {
+				return (pmk_hashMix(TAG_INTEGER ^ (uint64_t)(int64_t)n));
+			}
+			return (pmk_hash64(&n, sizeof(n), TAG_FLOAT));
+		}
+
+	case LUA_TSTRING: {
+		size_t len;
+		const char* s = lua_tolstring(L, index, &len);
+		return (pmk_hash64(s, len, TAG_STRING));
+	}
+
+	case LUA_TTABLE:
+		return (hashTable(L, index, hs));
+
+	default:
+		/* functions, userdata, threads: only identity is meaningful */
+		return (pmk_hashMix(TAG_OTHER ^ (uint64_t)(uintptr_t)lua_topointer(L, index)));
+	}
+}
+
+
+/**
+ * Compute a 64-bit structural hash of a Lua value. Tables are hashed by their contents,
+ * recursively, and without regard to key order; two tables with the same key-value pairs
+ * will hash to the same value. Functions and userdata are hashed by identity, so hashes
+ * are only stable for the lifetime of the Lua state.
+ */
+uint64_t pmk_hashValue(lua_State* L, int index)
+{
+	HashState hs;
+	hs.depth = 0;
+	return (hashValue(L, lua_absindex(L, index), &hs));
+}
@@ -24,6 +24,21 @@ int pmk_load(lua_State* L, const char* filename)
 		return (status);
 	}
 
+	/* Keep a list of every script loaded during the run in `_PREMAKE.LOADED_SCRIPTS` */
+	char scriptPath[PATH_MAX];
+	pmk_getAbsolutePath(scriptPath, filename, NULL);
+
+	lua_getglobal(L, "_PREMAKE");
+	if (lua_istable(L, -1)) {
+		lua_getfield(L, -1, "LOADED_SCRIPTS");
+		if (lua_istable(L, -1)) {
+			lua_pushboolean(L, TRUE);
+			lua_setfield(L, -2, scriptPath);
+		}
+		lua_pop(L, 1);
+	}
+	lua_pop(L, 1);
+
 	/* The loaded chunk is now on the stack. Wrap it together with its filename
 	 * into a closure that can be called to prepare the _SCRIPT globals prior
 	 * to running the chunk. */
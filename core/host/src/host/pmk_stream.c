@@ -0,0 +1,273 @@
+/**
+ * Streams generated output to a file, comparing it against the file's existing
+ * contents as it goes. Nothing is written to disk while the new output matches
+ * the old; on the first difference the matching prefix and everything after it
+ * are written to a temporary file, which replaces the original when the stream
+ * is closed. Only the chunk being compared ever needs to be held in memory.
+ */
+
+#include "../premake_internal.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if !PLATFORM_WINDOWS
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+struct pmk_Stream
+{
+	char path[PATH_MAX];
+	char tempPath[PATH_MAX];
+
+	/* The existing file contents, mapped read-only; NULL if empty or missing */
+	const char* existing;
+	size_t existingSize;
+#if PLATFORM_WINDOWS
+	HANDLE fileHandle;
+	HANDLE mappingHandle;
+#endif
+
+	/* Number of bytes streamed so far */
+	size_t offset;
+
+	/* Temporary output; only opened once the output differs from the existing file */
+	FILE* out;
+	int failed;
+};
+
+
+static void mapExisting(pmk_Stream* s)
+{
+#if PLATFORM_WINDOWS
+	wchar_t widePath[PATH_MAX];
+	LARGE_INTEGER size;
+
+	if (MultiByteToWideChar(CP_UTF8, 0, s->path, -1, widePath, PATH_MAX) == 0)
+		return;
+
+	s->fileHandle = CreateFileW(widePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (s->fileHandle == INVALID_HANDLE_VALUE)
+		return;
+
+	if (!GetFileSizeEx(s->fileHandle, &size) || size.QuadPart == 0)
+		return;
+
+	s->mappingHandle = CreateFileMappingW(s->fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (s->mappingHandle == NULL)
+		return;
+
+	s->existing = (const char*)MapViewOfFile(s->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (s->existing != NULL)
+		s->existingSize = (size_t)size.QuadPart;
+#else
+	struct stat info;
+
+	int fd = open(s->path, O_RDONLY);
+	if (fd < 0)
+		return;
+
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+		void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			s->existing = (const char*)data;
+			s->existingSize = (size_t)info.st_size;
+		}
+	}
+
+	/* the mapping remains valid after the descriptor is closed */
+	close(fd);
+#endif
+}
+
+
+static void unmapExisting(pmk_Stream* s)
+{
+#if PLATFORM_WINDOWS
+	if (s->existing != NULL)
+		UnmapViewOfFile(s->existing);
+	if (s->mappingHandle != NULL)
+		CloseHandle(s->mappingHandle);
+	if (s->fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(s->fileHandle);
+	s->mappingHandle = NULL;
+	s->fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (s->existing != NULL)
+		munmap((void*)s->existing, s->existingSize);
+#endif
+	s->existing = NULL;
+	s->existingSize = 0;
+}
+
+
+/**
+ * Switch from comparing to writing: open the temporary file and copy over the
+ * part of the existing file which has matched so far.
+ */
+static int diverge(pmk_Stream* s)
+{
+	s->out = pmk_openFile(s->tempPath, "wb");
+	if (s->out == NULL)
+		return (FALSE);
+
+	if (s->offset > 0 && fwrite(s->existing, 1, s->offset, s->out) != s->offset)
+		return (FALSE);
+
+	return (TRUE);
+}
+
+
+static int replaceFile(const char* from, const char* to)
+{
+#if PLATFORM_WINDOWS
+	wchar_t wideFrom[PATH_MAX];
+	wchar_t wideTo[PATH_MAX];
+	if (MultiByteToWideChar(CP_UTF8, 0, from, -1, wideFrom, PATH_MAX) == 0 ||
+		MultiByteToWideChar(CP_UTF8, 0, to, -1, wideTo, PATH_MAX) == 0)
+		return (FALSE);
+	return (MoveFileExW(wideFrom, wideTo, MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+	return (rename(from, to) == 0);
+#endif
+}
+
+
+static void removeFile(const char* path)
+{
+#if PLATFORM_WINDOWS
+	wchar_t widePath[PATH_MAX];
+	if (MultiByteToWideChar(CP_UTF8, 0, path, -1, widePath, PATH_MAX) > 0)
+		DeleteFileW(widePath);
+#else
+	remove(path);
+#endif
+}
+
+
+/**
+ * Begin streaming to a file.
+ *
+ * @param path
+ *    The file to be written. Any existing contents are mapped into memory for
+ *    comparison; the file itself is not touched until `pmk_streamClose()`.
+ * @returns
+ *    A new stream, or NULL if the path is too long or memory is exhausted.
+ */
+pmk_Stream* pmk_streamOpen(const char* path)
+{
+	size_t len = strlen(path);
+	if (len + 5 > PATH_MAX)
+		return (NULL);
+
+	pmk_Stream* s = (pmk_Stream*)calloc(1, sizeof(struct pmk_Stream));
+	if (s == NULL)
+		return (NULL);
+
+	memcpy(s->path, path, len + 1);
+	memcpy(s->tempPath, path, len);
+	memcpy(s->tempPath + len, ".tmp", 5);
+
+#if PLATFORM_WINDOWS
+	s->fileHandle = INVALID_HANDLE_VALUE;
+#endif
+	mapExisting(s);
+	return (s);
+}
+
+
+/**
+ * Stream the next chunk of output.
+ *
+ * @returns
+ *    `TRUE` on success, `FALSE` if the temporary file could not be written.
+ */
+int pmk_streamWrite(pmk_Stream* s, const char* data, size_t len)
+{
+	if (s->failed)
+		return (FALSE);
+
+	if (len == 0)
+		return (TRUE);
+
+	if (s->out == NULL) {
+		if (s->offset + len <= s->existingSize && memcmp(s->existing + s->offset, data, len) == 0) {
+			s->offset += len;
+			return (TRUE);
+		}
+
+		if (!diverge(s)) {
+			s->failed = TRUE;
+			return (FALSE);
+		}
+	}
+
+	if (fwrite(data, 1, len, s->out) != len) {
+		s->failed = TRUE;
+		return (FALSE);
+	}
+
+	s->offset += len;
+	return (TRUE);
+}
+
+
+/**
+ * Finish the stream, replacing the target file if the output differed from its
+ * previous contents, and release the stream.
+ *
+ * @returns
+ *    1 if the file was updated, 0 if the output matched the existing file and
+ *    nothing was written, or -1 if the file could not be written.
+ */
+int pmk_streamClose(pmk_Stream* s)
+{
+	int result;
+
+	/* The new output is a prefix of the existing file (or an empty file is new) */
+	if (s->out == NULL && !s->failed && (s->offset < s->existingSize || !pmk_isFile(s->path))) {
+		if (!diverge(s))
+			s->failed = TRUE;
+	}
+
+	if (s->out == NULL && !s->failed) {
+		result = 0;
+	}
+	else {
+		if (s->out != NULL && fclose(s->out) != 0)
+			s->failed = TRUE;
+		s->out = NULL;
+
+		/* Windows won't replace a file which is still mapped */
+		unmapExisting(s);
+
+		if (!s->failed && replaceFile(s->tempPath, s->path)) {
+			result = 1;
+		}
+		else {
+			removeFile(s->tempPath);
+			result = -1;
+		}
+	}
+
+	unmapExisting(s);
+	free(s);
+	return (result);
+}
+
+
+/**
+ * Abandon the stream, leaving the target file untouched.
+ */
+void pmk_streamAbort(pmk_Stream* s)
+{
+	if (s->out != NULL) {
+		fclose(s->out);
+		removeFile(s->tempPath);
+	}
+
+	unmapExisting(s);
+	free(s);
+}
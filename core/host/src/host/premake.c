@@ -27,15 +27,29 @@ static const luaL_Reg g_functions[] = {
 
 static const luaL_Reg buffer_functions[] = {
 	{ "new", pmk_buffer_new },
+	{ "appendf", pmk_buffer_appendf },
+	{ "appendLinef", pmk_buffer_appendLinef },
 	{ "close", pmk_buffer_close },
+	{ "eol", pmk_buffer_eol },
+	{ "finish", pmk_buffer_finish },
+	{ "indent", pmk_buffer_indent },
+	{ "indentString", pmk_buffer_indentString },
+	{ "isEmpty", pmk_buffer_isEmpty },
+	{ "reserve", pmk_buffer_reserve },
+	{ "reset", pmk_buffer_reset },
+	{ "splice", pmk_buffer_splice },
+	{ "stream", pmk_buffer_stream },
 	{ "toString", pmk_buffer_toString },
 	{ "write", pmk_buffer_write },
+	{ "writef", pmk_buffer_writef },
 	{ "writeLine", pmk_buffer_writeLine },
+	{ "writeLinef", pmk_buffer_writeLinef },
 	{ NULL, NULL }
 };
 
 static const luaL_Reg io_functions[] = {
 	{ "compareFile", pmk_io_compareFile },
+	{ "hashFile", pmk_io_hashFile },
 	{ "writeFile", pmk_io_writeFile },
 	{ NULL, NULL }
 };
@@ -58,6 +72,7 @@ static const luaL_Reg path_functions[] = {
 	{ "getAbsolute", pmk_path_getAbsolute },
 	{ "getBaseName", pmk_path_getBaseName },
 	{ "getDirectory", pmk_path_getDirectory },
+	{ "getExtension", pmk_path_getExtension },
 	{ "getKind", pmk_path_getKind },
 	{ "getName", pmk_path_getName },
 	{ "getRelative", pmk_path_getRelative },
@@ -80,11 +95,18 @@ static const luaL_Reg string_functions[] = {
 	{ "endsWith", pmk_string_endsWith },
 	{ "join", pmk_string_join },
 	{ "hash", pmk_string_hash },
+	{ "hash64", pmk_string_hash64 },
 	{ "patternFromWildcards", pmk_string_patternFromWildcards },
 	{ "startsWith", pmk_string_startsWith },
 	{ NULL, NULL }
 };
 
+static const luaL_Reg table_functions[] = {
+	{ "hash", pmk_table_hash },
+	{ "new", pmk_table_new },
+	{ NULL, NULL }
+};
+
 static const luaL_Reg terminal_functions[] = {
 	{ "textColor", pmk_terminal_textColor },
 	{ NULL, NULL }
@@ -114,6 +136,8 @@ pmk_State* pmk_init(pmk_ErrorHandler onError)
 
 	/* Create a "_PREMAKE" global to hold meta about the run */
 	lua_newtable(L);
+	lua_newtable(L);
+	lua_setfield(L, -2, "LOADED_SCRIPTS");
 	lua_setglobal(L, "_PREMAKE");
 
 	/* Add some metadata to the _PREMAKE global */
@@ -127,6 +151,7 @@ pmk_State* pmk_init(pmk_ErrorHandler onError)
 	registerGlobalLibrary(L, "io", io_functions);
 	registerGlobalLibrary(L, "os", os_functions);
 	registerGlobalLibrary(L, "string", string_functions);
+	registerGlobalLibrary(L, "table", table_functions);
 
 	registerInternalLibrary(L, "buffer", buffer_functions);
 	registerInternalLibrary(L, "path", path_functions);
@@ -1,42 +1,397 @@
 /**
  * Implementations for Premake's `buffer.*` functions.
+ *
+ * Buffers are handed to Lua as full userdata, so any buffer that is abandoned,
+ * e.g. when an exporter raises an error mid-capture, is still released by the
+ * garbage collector.
  */
 
 #include "../premake_internal.h"
+#include <string.h>
+
+#define PMK_BUFFER_TYPE  "pmk_Buffer"
+
+
+/**
+ * Retrieve the buffer at the given stack index, raising an error if the value is not
+ * a buffer or if the buffer has already been closed.
+ */
+static pmk_Buffer* checkBuffer(lua_State* L, int index)
+{
+	pmk_Buffer** ud = (pmk_Buffer**)luaL_checkudata(L, index, PMK_BUFFER_TYPE);
+	if (*ud == NULL) {
+		luaL_error(L, "attempt to use a closed buffer");
+	}
+	return (*ud);
+}
+
+
+static void checkResult(lua_State* L, int result)
+{
+	if (!result) {
+		luaL_error(L, "not enough memory to grow buffer");
+	}
+}
+
+
+/**
+ * Length of the buffer's contents, ignoring any trailing end-of-line.
+ */
+static size_t contentLength(pmk_Buffer* b)
+{
+	size_t len = pmk_bufferLen(b);
+	const char* contents = pmk_bufferContents(b);
+
+	if (len > 0 && contents[len - 1] == '\n')
+		--len;
+	if (len > 0 && contents[len - 1] == '\r')
+		--len;
+
+	return (len);
+}
+
+
+/**
+ * Format the arguments starting at `fmtIndex` into the buffer, following the rules
+ * of `string.format()`. The plain `%s` and `%d` conversions which make up nearly all
+ * exporter output are written straight into the buffer; anything fancier (widths,
+ * precisions, floats, `%q`, etc.) is handed off to `string.format()` one conversion
+ * at a time.
+ */
+static void format(lua_State* L, pmk_Buffer* b, int fmtIndex)
+{
+	size_t fmtLen;
+	const char* fmt = luaL_checklstring(L, fmtIndex, &fmtLen);
+	const char* end = fmt + fmtLen;
+	int arg = fmtIndex;
+
+	while (fmt < end)
+	{
+		const char* pct = memchr(fmt, '%', end - fmt);
+		if (pct == NULL) {
+			checkResult(L, pmk_bufferPuts(b, fmt, end - fmt));
+			return;
+		}
+
+		checkResult(L, pmk_bufferPuts(b, fmt, pct - fmt));
+		fmt = pct + 1;
+
+		if (fmt < end && *fmt == '%') {
+			checkResult(L, pmk_bufferPuts(b, "%", 1));
+			++fmt;
+			continue;
+		}
+
+		++arg;
+
+		if (fmt < end && *fmt == 's') {
+			size_t len;
+			luaL_checkany(L, arg);
+			const char* value = luaL_tolstring(L, arg, &len);
+			checkResult(L, pmk_bufferPuts(b, value, len));
+			lua_pop(L, 1);
+			++fmt;
+		}
+		else if (fmt < end && (*fmt == 'd' || *fmt == 'i')) {
+			lua_Integer value = luaL_checkinteger(L, arg);
+			checkResult(L, pmk_bufferPrintf(b, LUA_INTEGER_FMT, (LUAI_UACINT)value));
+			++fmt;
+		}
+		else {
+			/* Flags, width, precision, and the conversion itself */
+			const char* spec = fmt;
+			while (fmt < end && strchr("-+ #0123456789.", *fmt) != NULL)
+				++fmt;
+			if (fmt < end)
+				++fmt;
+
+			lua_getglobal(L, "string");
+			lua_getfield(L, -1, "format");
+			lua_remove(L, -2);
+			lua_pushliteral(L, "%");
+			lua_pushlstring(L, spec, fmt - spec);
+			lua_concat(L, 2);
+			lua_pushvalue(L, arg);
+			lua_call(L, 2, 1);
+
+			size_t len;
+			const char* value = lua_tolstring(L, -1, &len);
+			checkResult(L, pmk_bufferPuts(b, value, len));
+			lua_pop(L, 1);
+		}
+	}
+}
+
+
+/**
+ * Release the buffer's memory, if it hasn't been released already. Used as both the
+ * `__gc` and `__close` metamethods.
+ */
+static int releaseBuffer(lua_State* L)
+{
+	pmk_Buffer** ud = (pmk_Buffer**)luaL_checkudata(L, 1, PMK_BUFFER_TYPE);
+	if (*ud != NULL) {
+		pmk_bufferClose(*ud);
+		*ud = NULL;
+	}
+	return (0);
+}
 
 
 int pmk_buffer_new(lua_State* L)
 {
-	pmk_Buffer* b = pmk_bufferInit();
-	lua_pushlightuserdata(L, b);
+	lua_Integer capacity = luaL_optinteger(L, 1, 0);
+	pmk_Buffer* source = lua_isnoneornil(L, 2) ? NULL : checkBuffer(L, 2);
+
+	pmk_Buffer** ud = (pmk_Buffer**)lua_newuserdata(L, sizeof(pmk_Buffer*));
+	*ud = NULL;
+
+	if (luaL_newmetatable(L, PMK_BUFFER_TYPE)) {
+		lua_pushcfunction(L, releaseBuffer);
+		lua_setfield(L, -2, "__gc");
+		lua_pushcfunction(L, releaseBuffer);
+		lua_setfield(L, -2, "__close");
+	}
+	lua_setmetatable(L, -2);
+
+	*ud = pmk_bufferInit();
+	if (*ud == NULL) {
+		luaL_error(L, "not enough memory to create buffer");
+	}
+
+	if (capacity > 0) {
+		checkResult(L, pmk_bufferReserve(*ud, (size_t)capacity));
+	}
+
+	if (source != NULL) {
+		checkResult(L, pmk_bufferCopyFormat(*ud, source));
+	}
+
+	return (1);
+}
+
+
+/**
+ * `buffer.appendf(b, fmt, ...)`: write formatted text, without indentation.
+ */
+int pmk_buffer_appendf(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+	if (lua_gettop(L) > 1) {
+		format(L, b, 2);
+	}
+	return (0);
+}
+
+
+/**
+ * `buffer.appendLinef(b, fmt, ...)`: write formatted text, without indentation,
+ * followed by the buffer's end-of-line sequence.
+ */
+int pmk_buffer_appendLinef(lua_State* L)
+{
+	pmk_buffer_appendf(L);
+	checkResult(L, pmk_bufferPutEol(checkBuffer(L, 1)));
+	return (0);
+}
+
+
+/**
+ * `buffer.eol(b, [value])`: set the end-of-line sequence used by the line-oriented
+ * writes. Returns the current value.
+ */
+int pmk_buffer_eol(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+
+	if (!lua_isnoneornil(L, 2)) {
+		size_t len;
+		const char* value = luaL_checklstring(L, 2, &len);
+		checkResult(L, pmk_bufferSetEol(b, value, len));
+	}
+
+	size_t len;
+	const char* eol = pmk_bufferEol(b, &len);
+	lua_pushlstring(L, eol, len);
+	return (1);
+}
+
+
+/**
+ * `buffer.finish(b)`: complete a stream started with `buffer.stream()`. Returns
+ * true if the file was updated, or false if it already held the same contents.
+ * On failure, returns nil and an error message.
+ */
+int pmk_buffer_finish(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+	luaL_argcheck(L, pmk_bufferIsStreaming(b), 1, "buffer is not streaming");
+
+	int result = pmk_bufferFinishStream(b);
+	if (result >= 0) {
+		lua_pushboolean(L, result);
+		return (1);
+	} else {
+		lua_pushnil(L);
+		lua_pushliteral(L, "unable to write streamed file");
+		return (2);
+	}
+}
+
+
+/**
+ * `buffer.indent(b, [amount])`: adjust the indent level by `amount`, default 1. Pass
+ * a negative amount to outdent. Returns the new level.
+ */
+int pmk_buffer_indent(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+	lua_Integer amount = luaL_optinteger(L, 2, 1);
+
+	pmk_bufferIndent(b, (long)amount);
+	lua_pushinteger(L, (lua_Integer)pmk_bufferIndentLevel(b));
 	return (1);
 }
 
 
+/**
+ * `buffer.indentString(b, [value])`: set the string written once per indent level.
+ * Returns the current value.
+ */
+int pmk_buffer_indentString(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+
+	if (!lua_isnoneornil(L, 2)) {
+		size_t len;
+		const char* value = luaL_checklstring(L, 2, &len);
+		checkResult(L, pmk_bufferSetIndentString(b, value, len));
+	}
+
+	size_t len;
+	const char* indent = pmk_bufferIndentString(b, &len);
+	lua_pushlstring(L, indent, len);
+	return (1);
+}
+
+
+/**
+ * `buffer.isEmpty(b)`: true if the buffer holds nothing beyond a trailing end-of-line.
+ */
+int pmk_buffer_isEmpty(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+	lua_pushboolean(L, contentLength(b) == 0);
+	return (1);
+}
+
+
+int pmk_buffer_reserve(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+	lua_Integer capacity = luaL_checkinteger(L, 2);
+
+	if (capacity > 0) {
+		checkResult(L, pmk_bufferReserve(b, (size_t)capacity));
+	}
+
+	return (0);
+}
+
+
+/**
+ * `buffer.reset(b, [source])`: discard the buffer's contents so it can be reused. If
+ * a source buffer is provided, its formatting is copied as well.
+ */
+int pmk_buffer_reset(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+	pmk_bufferReset(b);
+
+	if (!lua_isnoneornil(L, 2)) {
+		checkResult(L, pmk_bufferCopyFormat(b, checkBuffer(L, 2)));
+	}
+
+	return (0);
+}
+
+
+/**
+ * `buffer.splice(b, source)`: append the contents of `source`, less any trailing
+ * end-of-line, followed by the end-of-line of `b`. Equivalent to writing the result
+ * of `buffer.toString(source)` as a line, without creating the intermediate string.
+ */
+int pmk_buffer_splice(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+	pmk_Buffer* source = checkBuffer(L, 2);
+	luaL_argcheck(L, b != source, 2, "cannot splice a buffer into itself");
+
+	checkResult(L, pmk_bufferPuts(b, pmk_bufferContents(source), contentLength(source)));
+	checkResult(L, pmk_bufferPutEol(b));
+	return (0);
+}
+
+
+/**
+ * `buffer.stream(b, path, [chunkSize])`: stream the buffer's output to `path`, in
+ * chunks of `chunkSize` bytes (64K if not provided). The file is only rewritten if the
+ * output differs from what is already there; call `buffer.finish()` to complete the
+ * export.
+ */
+int pmk_buffer_stream(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+	const char* path = luaL_checkstring(L, 2);
+	lua_Integer chunkSize = luaL_optinteger(L, 3, 0);
+
+	if (!pmk_bufferStream(b, path, (chunkSize > 0) ? (size_t)chunkSize : 0)) {
+		luaL_error(L, "unable to stream to '%s'", path);
+	}
+
+	return (0);
+}
+
+
 int pmk_buffer_write(lua_State* L)
 {
-	pmk_Buffer* b = (pmk_Buffer*)lua_touserdata(L, 1);
+	pmk_Buffer* b = checkBuffer(L, 1);
 
 	size_t len;
 	const char* s = luaL_checklstring(L, 2, &len);
 
-	pmk_bufferPuts(b, s, len);
+	checkResult(L, pmk_bufferPuts(b, s, len));
+	return (0);
+}
+
+
+/**
+ * `buffer.writef(b, fmt, ...)`: write the current indentation followed by formatted
+ * text. Writes nothing if no format is provided.
+ */
+int pmk_buffer_writef(lua_State* L)
+{
+	pmk_Buffer* b = checkBuffer(L, 1);
+	if (lua_gettop(L) > 1) {
+		checkResult(L, pmk_bufferPutIndent(b));
+		format(L, b, 2);
+	}
 	return (0);
 }
 
 
 int pmk_buffer_writeLine(lua_State* L)
 {
-	pmk_Buffer* b = (pmk_Buffer*)lua_touserdata(L, 1);
+	pmk_Buffer* b = checkBuffer(L, 1);
 
 	size_t len;
 	const char* s = luaL_optlstring(L, 2, NULL, &len);
 
 	if (s != NULL) {
-		pmk_bufferPuts(b, s, len);
+		checkResult(L, pmk_bufferPuts(b, s, len));
 	}
 
-	pmk_bufferPuts(b, "\r\n", 2);
+	checkResult(L, pmk_bufferPuts(b, "\r\n", 2));
 	return (0);
 }
 
@@ -45,31 +400,37 @@ int pmk_buffer_close(lua_State* L)
 {
 	pmk_buffer_toString(L);
 
-	pmk_Buffer* b = (pmk_Buffer*)lua_touserdata(L, 1);
-	pmk_bufferClose(b);
+	/* free the memory now rather than waiting on the collector */
+	pmk_Buffer** ud = (pmk_Buffer**)lua_touserdata(L, 1);
+	pmk_bufferClose(*ud);
+	*ud = NULL;
 	return (1);
 }
 
 
 int pmk_buffer_toString(lua_State* L)
 {
-	pmk_Buffer* b = (pmk_Buffer*)lua_touserdata(L, 1);
+	pmk_Buffer* b = checkBuffer(L, 1);
 
-	size_t len = pmk_bufferLen(b);
-	const char* contents = pmk_bufferContents(b);
-
-	if (len > 0) {
-		/* trim EOL from end of buffer */
-		if (contents[len - 1] == '\n')
-			--len;
-		if (contents[len - 1] == '\r')
-			--len;
-	}
+	/* trim EOL from end of buffer */
+	size_t len = contentLength(b);
 
 	if (len > 0)
-		lua_pushlstring(L, contents, len);
+		lua_pushlstring(L, pmk_bufferContents(b), len);
 	else
 		lua_pushstring(L, "");
 
 	return (1);
 }
+
+
+/**
+ * `buffer.writeLinef(b, fmt, ...)`: write the current indentation, formatted text,
+ * and the end-of-line sequence in one call. With no format, writes a blank line.
+ */
+int pmk_buffer_writeLinef(lua_State* L)
+{
+	pmk_buffer_writef(L);
+	checkResult(L, pmk_bufferPutEol(checkBuffer(L, 1)));
+	return (0);
+}
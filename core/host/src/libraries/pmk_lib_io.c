@@ -22,6 +22,22 @@ int pmk_io_compareFile(lua_State* L)
 }
 
 
+int pmk_io_hashFile(lua_State* L)
+{
+	const char* path = luaL_checkstring(L, 1);
+
+	uint64_t hash;
+	if (pmk_hashFile(path, &hash) == OKAY) {
+		lua_pushinteger(L, (lua_Integer)hash);
+		return (1);
+	} else {
+		lua_pushnil(L);
+		lua_pushfstring(L, "unable to read file '%s'", path);
+		return (2);
+	}
+}
+
+
 int pmk_io_writeFile(lua_State* L)
 {
 	const char* path = luaL_checkstring(L, 1);
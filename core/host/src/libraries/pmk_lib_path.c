@@ -34,6 +34,17 @@ int pmk_path_getDirectory(lua_State* L)
 }
 
 
+int pmk_path_getExtension(lua_State* L)
+{
+	char buffer[PATH_MAX];
+
+	const char* path = luaL_checkstring(L, 1);
+	pmk_getFileExtension(buffer, path);
+	lua_pushstring(L, buffer);
+	return (1);
+}
+
+
 int pmk_path_getName(lua_State* L)
 {
 	char buffer[PATH_MAX];
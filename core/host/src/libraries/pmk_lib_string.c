@@ -56,6 +56,16 @@ int pmk_string_hash(lua_State* L)
 }
 
 
+int pmk_string_hash64(lua_State* L)
+{
+	size_t len;
+	const char* value = luaL_checklstring(L, 1, &len);
+	uint64_t seed = (uint64_t)luaL_optinteger(L, 2, 0);
+	lua_pushinteger(L, (lua_Integer)pmk_hash64(value, len, seed));
+	return (1);
+}
+
+
 int pmk_string_patternFromWildcards(lua_State* L)
 {
 	char buffer[PATH_MAX];
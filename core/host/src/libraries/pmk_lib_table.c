@@ -0,0 +1,27 @@
+/**
+ * Implementations for Premake's `table.*` functions.
+ */
+
+#include "../premake_internal.h"
+
+
+int pmk_table_hash(lua_State* L)
+{
+	luaL_checkany(L, 1);
+	lua_pushinteger(L, (lua_Integer)pmk_hashValue(L, 1));
+	return (1);
+}
+
+
+/**
+ * Create a new, empty table with room preallocated for `narray` array elements and
+ * `nhash` keyed elements, so that a table of known size never has to grow.
+ */
+
+int pmk_table_new(lua_State* L)
+{
+	lua_Integer narray = luaL_optinteger(L, 1, 0);
+	lua_Integer nhash = luaL_optinteger(L, 2, 0);
+	lua_createtable(L, (narray > 0) ? (int)narray : 0, (nhash > 0) ? (int)nhash : 0);
+	return (1);
+}
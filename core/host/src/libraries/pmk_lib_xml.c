@@ -5,11 +5,58 @@
 #include "../premake_internal.h"
 
 
+/**
+ * Push an escaped copy of the value at `index`. If the value contains nothing
+ * which needs escaping, the original string is pushed as-is, without a copy.
+ */
+static void escapeValue(lua_State* L, int index)
+{
+	size_t len;
+	const char* value = lua_tolstring(L, index, &len);
+	if (value == NULL) {
+		luaL_error(L, "unable to escape value of type %s", luaL_typename(L, index));
+	}
+
+	size_t i = pmk_findXmlSpecial(value, len);
+	if (i == len) {
+		lua_pushvalue(L, index);
+		return;
+	}
+
+	luaL_Buffer b;
+	luaL_buffinit(L, &b);
+	luaL_addlstring(&b, value, i);
+	pmk_escapeXml(&b, value + i, len - i);
+	luaL_pushresult(&b);
+}
+
+
 int pmk_xml_escape(lua_State* L)
 {
-	char buffer[PATH_MAX];
-	const char* value = luaL_optstring(L, 1, "");
-	pmk_escapeXml(buffer, value);
-	lua_pushstring(L, buffer);
+	switch (lua_type(L, 1))
+	{
+	case LUA_TNONE:
+	case LUA_TNIL:
+		lua_pushstring(L, "");
+		break;
+
+	case LUA_TTABLE: {
+		/* escape an array of values in one call */
+		int n = (int)lua_rawlen(L, 1);
+		lua_createtable(L, n, 0);
+		for (int i = 1; i <= n; ++i) {
+			lua_rawgeti(L, 1, i);
+			escapeValue(L, -1);
+			lua_rawseti(L, -3, i);
+			lua_pop(L, 1);
+		}
+		break;
+	}
+
+	default:
+		escapeValue(L, 1);
+		break;
+	}
+
 	return (1);
 }
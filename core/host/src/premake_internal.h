@@ -39,6 +39,7 @@
 #else
 #include <unistd.h>
 #endif
+#include <stdarg.h>
 #include <stdint.h>
 
 /* Not all platforms define this */
@@ -68,29 +69,51 @@ struct pmk_State {
 
 
 typedef struct MatchInfo Matcher;
+typedef struct pmk_Stream pmk_Stream;
 
 typedef int (*LuaLoader)(lua_State* L, const char* filename, const char* mode);
 
 void  pmk_bufferClose(pmk_Buffer* b);
 const char* pmk_bufferContents(pmk_Buffer* b);
+int  pmk_bufferCopyFormat(pmk_Buffer* b, const pmk_Buffer* source);
+const char* pmk_bufferEol(pmk_Buffer* b, size_t* len);
+int  pmk_bufferFinishStream(pmk_Buffer* b);
+void pmk_bufferIndent(pmk_Buffer* b, long amount);
+size_t pmk_bufferIndentLevel(pmk_Buffer* b);
+const char* pmk_bufferIndentString(pmk_Buffer* b, size_t* len);
 pmk_Buffer* pmk_bufferInit();
+int  pmk_bufferIsStreaming(pmk_Buffer* b);
 size_t pmk_bufferLen(pmk_Buffer* b);
-void pmk_bufferPrintf(pmk_Buffer* b, const char* fmt, ...);
-void pmk_bufferPuts(pmk_Buffer* b, const char* ptr, size_t len);
+int  pmk_bufferPrintf(pmk_Buffer* b, const char* fmt, ...);
+int  pmk_bufferPrintfv(pmk_Buffer* b, const char* fmt, va_list args);
+int  pmk_bufferPutEol(pmk_Buffer* b);
+int  pmk_bufferPutIndent(pmk_Buffer* b);
+int  pmk_bufferPuts(pmk_Buffer* b, const char* ptr, size_t len);
+int  pmk_bufferReserve(pmk_Buffer* b, size_t capacity);
+void pmk_bufferReset(pmk_Buffer* b);
+int  pmk_bufferSetEol(pmk_Buffer* b, const char* value, size_t len);
+int  pmk_bufferSetIndentString(pmk_Buffer* b, const char* value, size_t len);
+int  pmk_bufferStream(pmk_Buffer* b, const char* path, size_t chunkSize);
 int  pmk_chdir(const char* path);
 int  pmk_compareFile(const char* path, const char* contents);
 int  pmk_doFile(lua_State* L, const char* filename);
 int  pmk_endsWith(const char* haystack, const char* needle);
-void pmk_escapeXml(char* result, const char* value);
+void pmk_escapeXml(luaL_Buffer* b, const char* value, size_t len);
+size_t pmk_findXmlSpecial(const char* value, size_t len);
 const char* pmk_getAbsolutePath(char* result, const char* value, const char* relativeTo);
 int  pmk_getCwd(char* result);
 void pmk_getDirectory(char* result, const char* value);
 int  pmk_getFileBaseName(char* result, const char* path);
+int  pmk_getFileExtension(char* result, const char* path);
 int  pmk_getFileName(char* result, const char* path);
 const char* pmk_getRelativeFile(char* result, const char* baseFile, const char* targetFile);
 const char* pmk_getRelativePath(char* result, const char* basePath, const char* targetPath);
 int  pmk_getTextColor();
 uint32_t pmk_hash(const char* value, int seed);
+uint64_t pmk_hash64(const void* data, size_t len, uint64_t seed);
+int  pmk_hashFile(const char* path, uint64_t* result);
+uint64_t pmk_hashMix(uint64_t value);
+uint64_t pmk_hashValue(lua_State* L, int index);
 int  pmk_isAbsolutePath(const char* path);
 int  pmk_isFile(const char* filename);
 void pmk_joinPath(char* root, const char* segment);
@@ -114,6 +137,10 @@ int  pmk_pathKind(const char* path);
 int  pmk_patternFromWildcards(char* result, int maxLen, const char* value, int isPath);
 int  pmk_pcall(lua_State* L, int nargs, int nresults);
 const char** pmk_searchPaths(lua_State* L);
+void pmk_streamAbort(pmk_Stream* s);
+int  pmk_streamClose(pmk_Stream* s);
+pmk_Stream* pmk_streamOpen(const char* path);
+int  pmk_streamWrite(pmk_Stream* s, const char* data, size_t len);
 int  pmk_startsWith(const char* haystack, const char* needle);
 int  pmk_testStrings(lua_State* L, int (*testFunction)(const char*, const char*));
 int  pmk_touchFile(const char* path);
@@ -132,15 +159,29 @@ int g_loadFileOpt(lua_State* L);
 /* I/O library extensions */
 
 int pmk_io_compareFile(lua_State* L);
+int pmk_io_hashFile(lua_State* L);
 int pmk_io_writeFile(lua_State* L);
 
 /* String buffer library extensions */
 
 int pmk_buffer_new(lua_State* L);
+int pmk_buffer_appendf(lua_State* L);
+int pmk_buffer_appendLinef(lua_State* L);
 int pmk_buffer_close(lua_State* L);
+int pmk_buffer_eol(lua_State* L);
+int pmk_buffer_finish(lua_State* L);
+int pmk_buffer_indent(lua_State* L);
+int pmk_buffer_indentString(lua_State* L);
+int pmk_buffer_isEmpty(lua_State* L);
+int pmk_buffer_reserve(lua_State* L);
+int pmk_buffer_reset(lua_State* L);
+int pmk_buffer_splice(lua_State* L);
+int pmk_buffer_stream(lua_State* L);
 int pmk_buffer_toString(lua_State* L);
 int pmk_buffer_write(lua_State* L);
+int pmk_buffer_writef(lua_State* L);
 int pmk_buffer_writeLine(lua_State* L);
+int pmk_buffer_writeLinef(lua_State* L);
 
 /* OS library extensions */
 
@@ -160,6 +201,7 @@ int pmk_os_uuid(lua_State* L);
 int pmk_path_getAbsolute(lua_State* L);
 int pmk_path_getBaseName(lua_State* L);
 int pmk_path_getDirectory(lua_State* L);
+int pmk_path_getExtension(lua_State* L);
 int pmk_path_getName(lua_State* L);
 int pmk_path_getKind(lua_State* L);
 int pmk_path_getRelative(lua_State* L);
@@ -180,9 +222,15 @@ int pmk_string_contains(lua_State* L);
 int pmk_string_endsWith(lua_State* L);
 int pmk_string_join(lua_State* L);
 int pmk_string_hash(lua_State* L);
+int pmk_string_hash64(lua_State* L);
 int pmk_string_patternFromWildcards(lua_State* L);
 int pmk_string_startsWith(lua_State* L);
 
+/* Table library extensions */
+
+int pmk_table_hash(lua_State* L);
+int pmk_table_new(lua_State* L);
+
 /* Terminal output library functions */
 
 int pmk_terminal_textColor(lua_State* L);
@@ -39,9 +39,7 @@ function array.appendArrays(self, ...)
 	local n = select('#', ...)
 	for i = 1, n do
 		local value = select(i, ...)
-		for j = 1, #value do
-			table.insert(self, value[j])
-		end
+		table.move(value, 1, #value, #self + 1, self)
 	end
 	return self
 end
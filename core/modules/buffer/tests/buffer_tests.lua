@@ -0,0 +1,124 @@
+local Buffer = require('buffer')
+
+local BufferTests = test.declare('BufferTests', 'buffer')
+
+
+function BufferTests.toString_returnsWrittenValues()
+	local b = Buffer.new()
+	Buffer.write(b, 'Hello, ')
+	Buffer.write(b, 'world')
+	test.isEqual('Hello, world', Buffer.close(b))
+end
+
+
+function BufferTests.toString_trimsTrailingEol()
+	local b = Buffer.new()
+	Buffer.writeLine(b, 'Hello')
+	test.isEqual('Hello', Buffer.close(b))
+end
+
+
+function BufferTests.toString_returnsEmptyString_onNoWrites()
+	local b = Buffer.new()
+	test.isEqual('', Buffer.close(b))
+end
+
+
+function BufferTests.write_growsBuffer_onLargeValues()
+	local b = Buffer.new(16)
+	local value = string.rep('abcdefgh', 10000)
+	Buffer.write(b, value)
+	Buffer.write(b, value)
+	test.isEqual(value .. value, Buffer.close(b))
+end
+
+
+function BufferTests.reserve_preservesContents()
+	local b = Buffer.new()
+	Buffer.write(b, 'Hello')
+	Buffer.reserve(b, 100000)
+	test.isEqual('Hello', Buffer.close(b))
+end
+
+
+function BufferTests.write_raisesError_onClosedBuffer()
+	local b = Buffer.new()
+	Buffer.close(b)
+	local ok = pcall(Buffer.write, b, 'Hello')
+	test.isFalse(ok)
+end
+
+
+function BufferTests.writef_formatsArguments()
+	local b = Buffer.new()
+	Buffer.writef(b, '<%s Id="%d">%%</%s>', 'Item', 42, 'Item')
+	test.isEqual('<Item Id="42">%</Item>', Buffer.close(b))
+end
+
+
+function BufferTests.writef_handsOffComplexConversions()
+	local b = Buffer.new()
+	Buffer.writef(b, '[%5s|%-3d|%.2f|%x]', 'ab', 7, 1.5, 255)
+	test.isEqual('[   ab|7  |1.50|ff]', Buffer.close(b))
+end
+
+
+function BufferTests.writef_prependsIndent()
+	local b = Buffer.new()
+	Buffer.indentString(b, '  ')
+	Buffer.indent(b, 2)
+	Buffer.writef(b, 'x')
+	Buffer.indent(b, -1)
+	Buffer.writef(b, 'y')
+	test.isEqual('    x  y', Buffer.close(b))
+end
+
+
+function BufferTests.writeLinef_appendsEol()
+	local b = Buffer.new()
+	Buffer.eol(b, '\r\n')
+	Buffer.writeLinef(b, 'a')
+	Buffer.writeLinef(b)
+	Buffer.writeLinef(b, 'b')
+	test.isEqual('a\r\n\r\nb', Buffer.close(b))
+end
+
+
+function BufferTests.indent_stopsAtZero()
+	local b = Buffer.new()
+	test.isEqual(0, Buffer.indent(b, -3))
+end
+
+
+function BufferTests.new_copiesFormatting_fromSource()
+	local source = Buffer.new()
+	Buffer.eol(source, '\r\n')
+	Buffer.indentString(source, '  ')
+	Buffer.indent(source)
+
+	local b = Buffer.new(nil, source)
+	Buffer.writeLinef(b, 'x')
+	Buffer.write(b, 'y')
+	test.isEqual('  x\r\ny', Buffer.close(b))
+end
+
+
+function BufferTests.splice_appendsContentsAsLine()
+	local b = Buffer.new()
+	local child = Buffer.new()
+	Buffer.writeLine(child, 'child')
+	Buffer.write(b, 'parent\n')
+	Buffer.splice(b, child)
+	Buffer.write(b, 'end')
+	test.isEqual('parent\nchild\nend', Buffer.close(b))
+end
+
+
+function BufferTests.reset_discardsContents()
+	local b = Buffer.new()
+	Buffer.write(b, 'old')
+	Buffer.reset(b)
+	test.isTrue(Buffer.isEmpty(b))
+	Buffer.write(b, 'new')
+	test.isEqual('new', Buffer.close(b))
+end
@@ -0,0 +1,642 @@
+---
+-- The script cache saves the contents of the store once the project scripts have run,
+-- so that later runs with the same inputs can load it instead of running the scripts
+-- again. The cache is only used when `--cache` is specified on the command line.
+--
+-- The cache is keyed by the contents of every script loaded during the run, the results
+-- of each file and directory glob made by the scripts, the values in `premake.env()`,
+-- the command line arguments, and the working directory. If any of these have changed,
+-- the scripts are run as usual and the cache is rewritten. Anything else a script reads,
+-- such as environment variables or the existence of a file, is not part of the key;
+-- use `--force` to run the scripts again when those change.
+--
+-- Scripts can also register modules, fields, and command line options as they run.
+-- Modules which were registered or required by the scripts are registered and required
+-- again when the cache is loaded; if that doesn't bring back every field and option the
+-- scripts defined, the cache is skipped. Any other changes, such as overriding a module's
+-- functions, can't be brought back by loading the cache, so those runs aren't cached.
+--
+-- The cache is written in a compact binary format: a header holding the key, followed
+-- by a table of interned strings, the names of the fields used, the unique conditions as
+-- trees of field and string indices, and finally the blocks themselves.
+---
+
+local Block = require('block')
+local Condition = require('condition')
+local Field = require('field')
+local options = require('options')
+local premake = require('premake')
+local Store = require('store')
+
+local cache = {}
+
+cache.FILENAME = '.premake6.cache'
+
+local _MAGIC = 'PMK6CACHE'
+local _FORMAT = 1
+
+local _OPERATIONS = { Block.ADD, Block.REMOVE }
+local _OPERATION_CODES = { [Block.ADD] = 1, [Block.REMOVE] = 2 }
+
+local _CONDITION_OPS = { 'MATCH', 'AND', 'OR', 'NOT' }
+local _CONDITION_OP_CODES = { MATCH = 1, AND = 2, OR = 3, NOT = 4 }
+
+local VALUE_STRING = 1
+local VALUE_LIST = 2
+local VALUE_SET = 3
+local VALUE_NUMBER = 4
+local VALUE_TRUE = 5
+local VALUE_FALSE = 6
+
+-- While recording, the globs made by the scripts: a list of { mask, type, hash }
+local _matches
+local _matched
+
+
+os.onMatch(function (mask, matchType, result)
+	if _matches ~= nil then
+		local key = matchType .. '\0' .. mask
+		if not _matched[key] then
+			_matched[key] = true
+			table.insert(_matches, { mask, matchType, table.hash(result) })
+		end
+	end
+end)
+
+
+local function _contextHash()
+	-- `--force` skips loading the cache, but shouldn't stop the next run from using it
+	return table.hash({ _PREMAKE.VERSION, premake.outputArgs(), os.getCwd(), premake.env() })
+end
+
+
+local function _keysOf(tbl)
+	local result = {}
+	for key in pairs(tbl) do
+		result[key] = true
+	end
+	return result
+end
+
+
+local function _newKeys(tbl, before)
+	local result = {}
+	for key in pairs(tbl) do
+		if not before[key] then
+			table.insert(result, key)
+		end
+	end
+	table.sort(result)
+	return result
+end
+
+
+---
+-- Take a snapshot of every table reachable from the loaded modules, so changes made by
+-- the scripts outside of the store, such as overriding an exporter's element functions,
+-- can be detected. Those changes would be lost when the cache is loaded in place of the
+-- scripts, so the run is not cached if any are found.
+--
+-- Globals and the module registry are skipped; modules registered or required by the
+-- scripts are replayed from the cache header instead. So are weak tables, which change
+-- whenever the garbage collector runs.
+---
+
+local function _snapshotModules()
+	local snapshot = {}
+	local visited = {
+		[_G] = true,
+		[package] = true,
+		[package.loaded] = true
+	}
+
+	local pending = {}
+	for _, module in pairs(package.loaded) do
+		if type(module) == 'table' then
+			table.insert(pending, module)
+		end
+	end
+
+	while #pending > 0 do
+		local tbl = table.remove(pending)
+		local mt = getmetatable(tbl)
+		if not visited[tbl] and not (type(mt) == 'table' and rawget(mt, '__mode')) then
+			visited[tbl] = true
+
+			local contents = {}
+			for key, value in next, tbl do
+				contents[key] = value
+				if type(key) == 'table' then
+					table.insert(pending, key)
+				end
+				if type(value) == 'table' then
+					table.insert(pending, value)
+				end
+			end
+			snapshot[tbl] = contents
+		end
+	end
+
+	return snapshot
+end
+
+
+local function _modulesChanged(snapshot)
+	for tbl, contents in pairs(snapshot) do
+		for key, value in next, tbl do
+			if contents[key] ~= value then
+				return true
+			end
+		end
+		for key, value in next, contents do
+			if rawget(tbl, key) ~= value then
+				return true
+			end
+		end
+	end
+	return false
+end
+
+
+local function _optionTriggers()
+	local result = {}
+	local definitions = options.getDefinitions()
+	for i = 1, #definitions do
+		result[definitions[i].trigger] = true
+	end
+	return result
+end
+
+
+---
+-- Writing. Output is collected as a list of packed strings; strings used by the body
+-- are interned as they are written, so the string table can be emitted ahead of it.
+---
+
+local function _write(writer, format, ...)
+	local parts = writer.parts
+	parts[#parts + 1] = string.pack(format, ...)
+end
+
+
+local function _writeStrings(writer, list)
+	_write(writer, '<I4', #list)
+	for i = 1, #list do
+		_write(writer, '<s4', list[i])
+	end
+end
+
+
+local function _stringId(writer, value)
+	local id = writer.stringIds[value]
+	if id == nil then
+		id = #writer.strings + 1
+		writer.strings[id] = value
+		writer.stringIds[value] = id
+	end
+	return id
+end
+
+
+local function _fieldId(writer, fieldName)
+	local id = writer.fieldIds[fieldName]
+	if id == nil then
+		id = #writer.fields + 1
+		writer.fields[id] = fieldName
+		writer.fieldIds[fieldName] = id
+	end
+	return id
+end
+
+
+local function _writeValue(writer, value)
+	local kind = type(value)
+
+	if kind == 'string' then
+		_write(writer, '<BI4', VALUE_STRING, _stringId(writer, value))
+	elseif kind == 'number' then
+		_write(writer, '<Bn', VALUE_NUMBER, value)
+	elseif kind == 'boolean' then
+		_write(writer, 'B', value and VALUE_TRUE or VALUE_FALSE)
+	elseif kind == 'table' then
+		local n = #value
+		local isSet = (n > 0 and value[value[1]] ~= nil)
+		_write(writer, '<BI4', isSet and VALUE_SET or VALUE_LIST, n)
+		for i = 1, n do
+			if not _writeValue(writer, value[i]) then
+				return false
+			end
+		end
+	else
+		return false
+	end
+
+	return true
+end
+
+
+local function _writeTree(writer, tree)
+	local op = tree[1]
+	if op == 'MATCH' then
+		_write(writer, '<BI4I4', _CONDITION_OP_CODES.MATCH, _fieldId(writer, tree[2]), _stringId(writer, tree[3]))
+	else
+		_write(writer, '<BI4', _CONDITION_OP_CODES[op], #tree - 1)
+		for i = 2, #tree do
+			_writeTree(writer, tree[i])
+		end
+	end
+end
+
+
+local function _encodeBody(blocks)
+	local writer = {
+		parts = {},
+		strings = {},
+		stringIds = {},
+		fields = {},
+		fieldIds = {}
+	}
+
+	local conditions = {}
+	local conditionIds = {}
+
+	for i = 1, #blocks do
+		local block = blocks[i]
+		local condition = block.condition
+
+		local conditionId = conditionIds[condition]
+		if conditionId == nil then
+			table.insert(conditions, condition)
+			conditionId = #conditions
+			conditionIds[condition] = conditionId
+		end
+
+		local fieldCount = 0
+		for _ in pairs(block.data) do
+			fieldCount = fieldCount + 1
+		end
+
+		_write(writer, '<BI4I4', _OPERATION_CODES[block.operation], conditionId, fieldCount)
+		for field, value in pairs(block.data) do
+			_write(writer, '<I4', _fieldId(writer, field.name))
+			if not _writeValue(writer, value) then
+				return nil
+			end
+		end
+	end
+
+	local blockParts = writer.parts
+	writer.parts = {}
+
+	_write(writer, '<I4', #conditions)
+	for i = 1, #conditions do
+		_writeTree(writer, Condition.toTree(conditions[i]))
+	end
+	local conditionParts = writer.parts
+
+	-- Fields and strings were interned by the blocks and conditions; emit them first
+	local fields = writer.fields
+	local fieldNameIds = {}
+	for i = 1, #fields do
+		fieldNameIds[i] = _stringId(writer, fields[i])
+	end
+
+	writer.parts = {}
+	_writeStrings(writer, writer.strings)
+	_write(writer, '<I4', #fields)
+	for i = 1, #fields do
+		_write(writer, '<I4', fieldNameIds[i])
+	end
+	_write(writer, '<I4', #blocks)
+
+	return table.concat(writer.parts) .. table.concat(conditionParts) .. table.concat(blockParts)
+end
+
+
+---
+-- Reading. Each function takes the data and a read position, and returns its value
+-- followed by the position of the next item.
+---
+
+local function _readStrings(data, pos)
+	local n
+	n, pos = string.unpack('<I4', data, pos)
+
+	local result = {}
+	for i = 1, n do
+		result[i], pos = string.unpack('<s4', data, pos)
+	end
+	return result, pos
+end
+
+
+local function _readValue(data, pos, strings)
+	local kind
+	kind, pos = string.unpack('B', data, pos)
+
+	if kind == VALUE_STRING then
+		local id
+		id, pos = string.unpack('<I4', data, pos)
+		return strings[id], pos
+	elseif kind == VALUE_NUMBER then
+		return string.unpack('<n', data, pos)
+	elseif kind == VALUE_TRUE then
+		return true, pos
+	elseif kind == VALUE_FALSE then
+		return false, pos
+	end
+
+	local n
+	n, pos = string.unpack('<I4', data, pos)
+
+	local result = {}
+	for i = 1, n do
+		local value
+		value, pos = _readValue(data, pos, strings)
+		result[i] = value
+		if kind == VALUE_SET then
+			result[value] = value
+		end
+	end
+	return result, pos
+end
+
+
+local function _readTree(data, pos, strings, fieldNames)
+	-- Operators are followed by a count of operands; MATCH by a field and a pattern
+	local code, n
+	code, n, pos = string.unpack('<BI4', data, pos)
+
+	local op = _CONDITION_OPS[code]
+	if op == 'MATCH' then
+		local patternId
+		patternId, pos = string.unpack('<I4', data, pos)
+		return { op, fieldNames[n], strings[patternId] }, pos
+	end
+
+	local tree = { op }
+	for i = 1, n do
+		tree[i + 1], pos = _readTree(data, pos, strings, fieldNames)
+	end
+	return tree, pos
+end
+
+
+local function _decodeBody(data, pos)
+	local strings, n
+	strings, pos = _readStrings(data, pos)
+
+	-- Every field used must have been registered again, by core or by a replayed module
+	local fields = {}
+	local fieldNames = {}
+	n, pos = string.unpack('<I4', data, pos)
+	for i = 1, n do
+		local id
+		id, pos = string.unpack('<I4', data, pos)
+		local field = Field.tryGet(strings[id])
+		if field == nil then
+			return nil
+		end
+		fields[i] = field
+		fieldNames[i] = field.name
+	end
+
+	local blockCount
+	blockCount, pos = string.unpack('<I4', data, pos)
+
+	local conditions = {}
+	n, pos = string.unpack('<I4', data, pos)
+	for i = 1, n do
+		local tree
+		tree, pos = _readTree(data, pos, strings, fieldNames)
+		conditions[i] = Condition.fromTree(tree)
+	end
+
+	local blocks = {}
+	for i = 1, blockCount do
+		local operation, conditionId, fieldCount
+		operation, conditionId, fieldCount, pos = string.unpack('<BI4I4', data, pos)
+
+		local blockData = {}
+		for j = 1, fieldCount do
+			local fieldId, value
+			fieldId, pos = string.unpack('<I4', data, pos)
+			value, pos = _readValue(data, pos, strings)
+			blockData[fields[fieldId]] = value
+		end
+
+		blocks[i] = Block.new(_OPERATIONS[operation], conditions[conditionId], blockData)
+	end
+
+	return blocks
+end
+
+
+---
+-- Check the key in the cache header against the current inputs, and replay the module
+-- registrations recorded there. Returns the position of the body, and the set of scripts
+-- loaded by the recording run, if the key matches.
+---
+
+local function _checkHeader(data)
+	local magic, format, contextHash, pos = string.unpack('<c' .. #_MAGIC .. 'I4i8', data)
+	if magic ~= _MAGIC or format ~= _FORMAT or contextHash ~= _contextHash() then
+		return nil
+	end
+
+	local n
+	n, pos = string.unpack('<I4', data, pos)
+
+	local scripts = {}
+	for i = 1, n do
+		local scriptPath, hash
+		scriptPath, hash, pos = string.unpack('<s4i8', data, pos)
+		if (io.hashFile(scriptPath) or 0) ~= hash then
+			return nil
+		end
+		scripts[scriptPath] = true
+	end
+
+	-- A script loaded this time around which wasn't loaded before, such as a newly
+	-- added system script, could change the results
+	for scriptPath in pairs(_PREMAKE.LOADED_SCRIPTS) do
+		if not scripts[scriptPath] then
+			return nil
+		end
+	end
+
+	n, pos = string.unpack('<I4', data, pos)
+	for i = 1, n do
+		local mask, matchType, hash
+		mask, matchType, hash, pos = string.unpack('<s4s4i8', data, pos)
+		local result = (matchType == 'dir') and os.matchDirs(mask) or os.matchFiles(mask)
+		if table.hash(result) ~= hash then
+			return nil
+		end
+	end
+
+	local registered, required, triggers
+	registered, pos = _readStrings(data, pos)
+	required, pos = _readStrings(data, pos)
+	triggers, pos = _readStrings(data, pos)
+
+	for i = 1, #registered do
+		if not tryRegister(registered[i]) then
+			return nil
+		end
+	end
+
+	for i = 1, #required do
+		require(required[i])
+	end
+
+	for i = 1, #triggers do
+		if options.definitionOf(triggers[i]) == nil then
+			return nil
+		end
+	end
+
+	return pos, scripts
+end
+
+
+---
+-- Load the store contents saved by an earlier run, if its inputs still match.
+--
+-- @param cachePath
+--    The path of the cache file.
+-- @param store
+--    The store to be populated.
+-- @returns
+--    True if the cache was loaded, and the scripts don't need to be run. False if the
+--    cache is missing or out of date, or `--force` was specified on the command line.
+---
+
+function cache.load(cachePath, store)
+	if options.isSet('--force') then
+		return false
+	end
+
+	local file = io.open(cachePath, 'rb')
+	if file == nil then
+		return false
+	end
+
+	local data = file:read('a')
+	file:close()
+
+	local scripts
+	local ok, blocks = pcall(function ()
+		local pos
+		pos, scripts = _checkHeader(data)
+		if pos ~= nil then
+			return _decodeBody(data, pos)
+		end
+	end)
+
+	if ok and blocks ~= nil then
+		Store.setBlocks(store, blocks)
+
+		-- The scripts were skipped, but their results are in play just the same; list
+		-- them as loaded so anything keyed on the loaded scripts sees the same set
+		for scriptPath in pairs(scripts) do
+			_PREMAKE.LOADED_SCRIPTS[scriptPath] = true
+		end
+
+		return true
+	end
+
+	return false
+end
+
+
+---
+-- Run the project scripts, recording the inputs they use, then save the contents of
+-- the store to the cache.
+--
+-- @param cachePath
+--    The path of the cache file.
+-- @param store
+--    The store being populated by the scripts.
+-- @param fn
+--    A function which runs the scripts.
+---
+
+function cache.record(cachePath, store, fn)
+	local contextHash = _contextHash()
+	local registeredBefore = _keysOf(package.registered)
+	local loadedBefore = _keysOf(package.loaded)
+	local triggersBefore = _optionTriggers()
+
+	-- Modules required by the scripts are required again when the cache is loaded, so
+	-- whatever they change while loading is brought back; only check for changes made
+	-- by the scripts themselves, and take a fresh snapshot once each new module loads
+	local modules = _snapshotModules()
+	local changed = false
+	local depth = 0
+
+	local _require = require
+	require = function (name)
+		if depth > 0 or package.loaded[name] ~= nil then
+			return _require(name)
+		end
+		changed = changed or _modulesChanged(modules)
+		depth = depth + 1
+		local module = _require(name)
+		depth = depth - 1
+		modules = _snapshotModules()
+		return module
+	end
+
+	_matches = {}
+	_matched = {}
+	local ok, err = pcall(fn)
+	local matches = _matches
+	_matches = nil
+	_matched = nil
+	require = _require
+
+	if not ok then
+		error(err, 0)
+	end
+
+	-- The scripts changed something which loading the cache wouldn't bring back
+	if changed or _modulesChanged(modules) then
+		os.remove(cachePath)
+		return
+	end
+
+	local body = _encodeBody(Store.blocks(store))
+	if body == nil then
+		-- Some value couldn't be saved; make sure an older cache isn't picked up instead
+		os.remove(cachePath)
+		return
+	end
+
+	local writer = { parts = {} }
+	_write(writer, '<c' .. #_MAGIC .. 'I4i8', _MAGIC, _FORMAT, contextHash)
+
+	local scripts = table.sortedKeys(_PREMAKE.LOADED_SCRIPTS)
+	_write(writer, '<I4', #scripts)
+	for i = 1, #scripts do
+		_write(writer, '<s4i8', scripts[i], io.hashFile(scripts[i]) or 0)
+	end
+
+	_write(writer, '<I4', #matches)
+	for i = 1, #matches do
+		_write(writer, '<s4s4i8', table.unpack(matches[i]))
+	end
+
+	_writeStrings(writer, _newKeys(package.registered, registeredBefore))
+	_writeStrings(writer, _newKeys(package.loaded, loadedBefore))
+	_writeStrings(writer, _newKeys(_optionTriggers(), triggersBefore))
+
+	local file = io.open(cachePath, 'wb')
+	if file ~= nil then
+		file:write(table.concat(writer.parts), body)
+		file:close()
+	end
+end
+
+
+return cache
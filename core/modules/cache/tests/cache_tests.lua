@@ -0,0 +1,219 @@
+local cache = require('cache')
+local Condition = require('condition')
+local Field = require('field')
+local premake = require('premake')
+local Store = require('store')
+
+local CacheTests = test.declare('CacheTests', 'cache')
+
+local _DEFINES = Field.get('defines')
+local _KIND = Field.get('kind')
+
+local _cachePath
+local _tempPath
+
+
+function CacheTests.setup()
+	_cachePath = os.tmpname()
+	_tempPath = os.tmpname()
+	os.remove(_cachePath)
+
+	package.loaded['cacheTestExporter'] = {
+		elements = {
+			project = function (prj)
+				return { 'globals', 'files' }
+			end
+		}
+	}
+end
+
+
+function CacheTests.teardown()
+	os.remove(_cachePath)
+	os.remove(_tempPath)
+	os.remove(_tempPath .. '2')
+	_PREMAKE.LOADED_SCRIPTS[_tempPath] = nil
+	package.loaded['cacheTestExporter'] = nil
+	package.loaded['cacheTestRequired'] = nil
+	package.preload['cacheTestRequired'] = nil
+end
+
+
+local function _preloadRequired()
+	package.preload['cacheTestRequired'] = function ()
+		require('cacheTestExporter').elements.required = function () end
+		return { elements = {} }
+	end
+end
+
+
+local function _record(fn)
+	local store = Store.new()
+	cache.record(_cachePath, store, function ()
+		store:addValue(_DEFINES, 'GLOBAL')
+		store:pushCondition({ system = 'Windows or MacOSX', kind = 'not StaticLib' })
+		store:addValue(_KIND, 'ConsoleApplication')
+		store:removeValue(_DEFINES, 'GLOBAL')
+		store:popCondition()
+		if fn then
+			fn()
+		end
+	end)
+	return store
+end
+
+
+---
+-- Loading should restore the blocks, with the same operations, conditions, and values.
+---
+
+function CacheTests.load_restoresBlocks()
+	local original = Store.blocks(_record())
+
+	local store = Store.new()
+	test.isTrue(cache.load(_cachePath, store))
+
+	local blocks = Store.blocks(store)
+	test.isEqual(#original, #blocks)
+	for i = 1, #blocks do
+		test.isEqual(original[i].operation, blocks[i].operation)
+		test.isEqual(Condition.hash(original[i].condition), Condition.hash(blocks[i].condition))
+		test.isEqual(original[i].data, blocks[i].data)
+	end
+end
+
+
+function CacheTests.load_restoresSetKeys()
+	_record()
+	local store = Store.new()
+	cache.load(_cachePath, store)
+	test.isEqual('GLOBAL', Store.blocks(store)[1].data[_DEFINES]['GLOBAL'])
+end
+
+
+function CacheTests.load_sharesConditions_betweenBlocks()
+	_record()
+	local store = Store.new()
+	cache.load(_cachePath, store)
+	local blocks = Store.blocks(store)
+	test.isTrue(blocks[2].condition == blocks[3].condition)
+end
+
+
+---
+-- Loading should fail if the cache is missing, or any part of its key has changed.
+---
+
+function CacheTests.load_fails_onMissingCache()
+	test.isFalse(cache.load(_cachePath, Store.new()))
+end
+
+
+function CacheTests.load_fails_onChangedEnv()
+	_record()
+	premake.env().cacheTest = 'changed'
+	local ok = cache.load(_cachePath, Store.new())
+	premake.env().cacheTest = nil
+	test.isFalse(ok)
+end
+
+
+function CacheTests.load_fails_onChangedScript()
+	io.writeFile(_tempPath, 'before')
+	_record(function ()
+		_PREMAKE.LOADED_SCRIPTS[_tempPath] = true
+	end)
+	io.writeFile(_tempPath, 'after')
+	test.isFalse(cache.load(_cachePath, Store.new()))
+end
+
+
+function CacheTests.load_fails_onChangedGlob()
+	_record(function ()
+		os.matchFiles(_tempPath .. '*')
+	end)
+	io.writeFile(_tempPath .. '2', 'new file')
+	test.isFalse(cache.load(_cachePath, Store.new()))
+end
+
+
+function CacheTests.load_succeeds_onUnchangedGlob()
+	_record(function ()
+		os.matchFiles(_tempPath .. '*')
+	end)
+	test.isTrue(cache.load(_cachePath, Store.new()))
+end
+
+
+---
+-- Changes the scripts make outside of the store would be lost by loading the cache in
+-- their place, so no cache should be written for those runs.
+---
+
+function CacheTests.record_skipsCache_onOverriddenExporterFunction()
+	_record(function ()
+		local exporter = require('cacheTestExporter')
+		exporter.elements.project = function (prj)
+			return { 'files' }
+		end
+	end)
+	test.isFalse(cache.load(_cachePath, Store.new()))
+end
+
+
+function CacheTests.record_skipsCache_onAddedModuleValue()
+	_record(function ()
+		require('cacheTestExporter').extraElement = function () end
+	end)
+	test.isFalse(cache.load(_cachePath, Store.new()))
+end
+
+
+function CacheTests.record_writesCache_onChangesMadeByRequiredModule()
+	_preloadRequired()
+	_record(function ()
+		require('cacheTestRequired')
+	end)
+	test.isTrue(cache.load(_cachePath, Store.new()))
+end
+
+
+function CacheTests.record_skipsCache_onOverriddenRequiredModuleFunction()
+	_preloadRequired()
+	_record(function ()
+		require('cacheTestRequired').elements.project = function () end
+	end)
+	test.isFalse(cache.load(_cachePath, Store.new()))
+end
+
+
+---
+-- An error raised by the scripts should be passed along, with the recording undone.
+---
+
+function CacheTests.record_restoresRequire_onError()
+	local _require = require
+	local ok, err = pcall(_record, function ()
+		error('script failed', 0)
+	end)
+	test.isFalse(ok)
+	test.isEqual('script failed', err)
+	test.isTrue(require == _require)
+end
+
+
+---
+-- Loading the cache stands in for loading the scripts, so the scripts recorded in the
+-- cache should be listed as loaded.
+---
+
+function CacheTests.load_marksRecordedScripts_asLoaded()
+	io.writeFile(_tempPath, 'script')
+	_record(function ()
+		_PREMAKE.LOADED_SCRIPTS[_tempPath] = true
+	end)
+	_PREMAKE.LOADED_SCRIPTS[_tempPath] = nil
+
+	cache.load(_cachePath, Store.new())
+	test.isTrue(_PREMAKE.LOADED_SCRIPTS[_tempPath])
+end
@@ -0,0 +1,53 @@
+---
+-- Measure condition testing, the innermost operation of every query.
+---
+
+local Condition = require('condition')
+local Field = require('field')
+local set = require('set')
+
+local ConditionBench = bench.declare('ConditionBench')
+
+
+local _WORKSPACES = Field.get('workspaces')
+local _PROJECTS = Field.get('projects')
+
+local _scope = {
+	[_WORKSPACES] = set.of('Workspace1'),
+	[_PROJECTS] = set.of('Project1')
+}
+
+local _values = {
+	[Field.get('configurations')] = set.of('Debug'),
+	[Field.get('kind')] = 'StaticLibrary'
+}
+
+local _condition = Condition.merge(
+	Condition.new({ workspaces = 'Workspace1', projects = 'Project1' }),
+	Condition.new({ configurations = 'Debug or Release', kind = 'not ConsoleApplication' })
+)
+
+
+function ConditionBench.matchesValues_100()
+	for i = 1, 100 do
+		Condition.matchesValues(_condition, _values, _scope)
+	end
+end
+
+
+function ConditionBench.new_100()
+	for i = 1, 100 do
+		Condition.new({ projects = 'Project' .. i, configurations = 'Debug' })
+	end
+end
+
+
+local _scopes = { _EMPTY, { [_WORKSPACES] = _scope[_WORKSPACES] }, _scope }
+
+
+function ConditionBench.matchesScopeAndValues_100()
+	local masks = Condition.scopeMasks(_scopes)
+	for i = 1, 100 do
+		Condition.matchesScopeAndValues(_condition, _values, _scopes, nil, masks)
+	end
+end
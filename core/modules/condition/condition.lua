@@ -23,88 +23,262 @@ local OP_NOT = 'NOT'
 
 local _allFieldsTested = {}
 
+-- Conditions are immutable, so identical ones can be shared: `_interned` maps normalized
+-- clauses to conditions, and `_merged` maps pairs of conditions to their merge
+local _interned = setmetatable({}, { __mode = 'v' })
+local _merged = setmetatable({}, { __mode = 'k' })
+
 
 ---
--- Create a new Condition instance.
---
--- @param clauses
---    A table of field-pattern pairs representing the clauses of the condition.
--- @return
---    A new Condition instance representing the specified clauses.
+-- Sets of fields, such as the fields tested by a condition or those named by a scope,
+-- are kept as bitsets of field ids: a list of integers, 64 fields to each.
 ---
 
-function Condition.new(clauses)
-	local self = Type.assign(Condition, {
-		_fieldsTested = {},
-		_rootTest = nil
-	})
+local function _setBit(mask, id)
+	local word = ((id - 1) >> 6) + 1
+	for i = #mask + 1, word do
+		mask[i] = 0
+	end
+	mask[word] = mask[word] | (1 << ((id - 1) & 63))
+end
 
-	local ok, result = pcall(function()
-		return Condition._parseCondition(self, clauses)
-	end)
 
-	if not ok then
-		error(result, 2)
+local function _unionMasks(left, right)
+	local result = {}
+	for i = 1, math.max(#left, #right) do
+		result[i] = (left[i] or 0) | (right[i] or 0)
 	end
+	return result
+end
 
-	self._rootTest = result
-	return self
+
+local function _scopeMask(scope, anyFields)
+	local mask = {}
+	for field in pairs(scope) do
+		if anyFields ~= nil and anyFields[field] then
+			mask.any = mask.any or {}
+			_setBit(mask.any, field.id)
+		else
+			_setBit(mask, field.id)
+		end
+	end
+	return mask
+end
+
+
+-- True if the condition tests any of the fields
+local function _testsAny(testedMask, anyMask)
+	for i = 1, #anyMask do
+		if (anyMask[i] & (testedMask[i] or 0)) ~= 0 then
+			return true
+		end
+	end
+	return false
+end
+
+
+-- True if every field in the scope is also tested by the condition
+local function _testsScope(testedMask, scopeMask)
+	local n = #scopeMask
+	if n == 1 then
+		if (scopeMask[1] & ~(testedMask[1] or 0)) ~= 0 then
+			return false
+		end
+	else
+		for i = 1, n do
+			local bits = scopeMask[i]
+			if bits ~= 0 and (bits & ~(testedMask[i] or 0)) ~= 0 then
+				return false
+			end
+		end
+	end
+
+	local anyMask = scopeMask.any
+	return (anyMask == nil or _testsAny(testedMask, anyMask))
 end
 
 
 ---
--- Matching function, evaluates a tree of test clauses against a specific collection
--- of values and scopes.
+-- Conditions are compiled into Lua functions, rather than interpreting the tree of
+-- clauses on every test. The generated source only depends on the shape of the tree,
+-- so conditions such as `{ projects = 'A' }` and `{ projects = 'B' }` share the same
+-- compiled chunk; the fields, matchers, and patterns are passed in as constants.
 ---
 
-local function _match(operation, values, scope, matchOnNil)
-	local result
+local _compiledChunks = {}
 
+-- Chunks with more constants than this index into the constant table instead of
+-- copying each into a local, to stay under Lua's limit on locals
+local _MAX_CONSTANT_LOCALS = 150
+
+
+local _compileOperation
+
+
+-- Nested ANDs, as built up by `Condition.merge()`, are flattened into their parent
+local function _compileOperands(op, operation, lines, constants, exitTest)
+	for i = 1, #operation do
+		local operand = operation[i]
+		if op == OP_AND and operand._op == OP_AND then
+			_compileOperands(op, operand, lines, constants, exitTest)
+		else
+			_compileOperation(operand, lines, constants)
+			table.insert(lines, exitTest)
+		end
+	end
+end
+
+
+_compileOperation = function (operation, lines, constants)
 	local op = operation._op
 
 	if op == OP_MATCH then
 
 		local field = operation[1]
-		local pattern = operation[2]
+		local n = #constants
+		constants[n + 1] = field
+		constants[n + 2] = field.match
+		constants[n + 3] = operation[2]
 
-		local testValue
-		if field.isScope and scope ~= nil then
-			testValue = scope[field]
+		local f, m, p = 'K' .. (n + 1), 'K' .. (n + 2), 'K' .. (n + 3)
+
+		if field.isScope then
+			table.insert(lines, string.format('if scope ~= nil then v = scope[%s] else v = values[%s] end', f, f))
 		else
-			testValue = values[field]
+			table.insert(lines, string.format('v = values[%s]', f))
 		end
+		table.insert(lines, string.format('if v then r = %s(%s, v, %s, true) else r = matchOnNil end', m, f, p))
+
+	elseif op == OP_AND or op == OP_OR then
+
+		-- A `repeat ... until true` block gives each operator a place to `break` out of
+		-- once its result is known
+		local exitTest = (op == OP_AND) and 'if not r then r = false break end' or 'if r then r = true break end'
+		table.insert(lines, 'repeat')
+		_compileOperands(op, operation, lines, constants, exitTest)
+		table.insert(lines, (op == OP_AND) and 'r = true' or 'r = false')
+		table.insert(lines, 'until true')
+
+	elseif op == OP_NOT then
+
+		_compileOperation(operation[1], lines, constants)
+		table.insert(lines, 'r = not r')
 
-		if testValue then
-			result = Field.matches(field, testValue, pattern, true)
+	end
+end
+
+
+---
+-- Compile a tree of clauses into a function of the form
+-- `function (values, scope, matchOnNil)` which returns true if the clauses match.
+---
+
+local function _compile(rootTest)
+	local lines = {}
+	local constants = {}
+	_compileOperation(rootTest, lines, constants)
+
+	local body = table.concat(lines, '\n')
+
+	local chunk = _compiledChunks[body]
+	if chunk == nil then
+		local source
+		if #constants <= _MAX_CONSTANT_LOCALS then
+			local names = {}
+			local values = {}
+			for i = 1, #constants do
+				names[i] = 'K' .. i
+				values[i] = 'K[' .. i .. ']'
+			end
+			if #constants > 0 then
+				source = string.format('local K = ...\nlocal %s = %s\n', table.concat(names, ', '), table.concat(values, ', '))
+			else
+				source = ''
+			end
+			source = source .. 'return function (values, scope, matchOnNil)\nlocal v, r\n' .. body
 		else
-			result = matchOnNil
+			source = 'local K = ...\nreturn function (values, scope, matchOnNil)\nlocal v, r\n' .. string.gsub(body, 'K(%d+)', 'K[%1]')
 		end
 
-	elseif op == OP_AND then
+		chunk = assert(load(source .. '\nreturn r\nend', '=condition', 't', {}))
+		_compiledChunks[body] = chunk
+	end
 
-		for i = 1, #operation do
-			if not _match(operation[i], values, scope, matchOnNil) then
-				return false
-			end
+	return chunk(constants)
+end
+
+
+---
+-- Build a key identifying a set of clauses regardless of the order in which they were
+-- listed, or `nil` if the clauses contain something other than strings.
+---
+
+local function _clausesKey(clauses)
+	local parts = {}
+	for key, pattern in pairs(clauses) do
+		if type(pattern) ~= 'string' then
+			return nil
 		end
-		return true
+		if type(key) == 'string' then
+			table.insert(parts, key .. '\1' .. pattern)
+		else
+			table.insert(parts, '\2' .. pattern)
+		end
+	end
+	table.sort(parts)
+	return table.concat(parts, '\0')
+end
 
-	elseif op == OP_NOT then
 
-		return not _match(operation[1], values, scope, matchOnNil)
+-- Interned conditions hold on to their fields; start over if a field goes away
+Field.onFieldRemoved(function ()
+	_interned = setmetatable({}, { __mode = 'v' })
+	_merged = setmetatable({}, { __mode = 'k' })
+end)
 
-	elseif op == OP_OR then
 
-		for i = 1, #operation do
-			if _match(operation[i], values, scope, matchOnNil) then
-				return true
-			end
+---
+-- Create a new Condition instance. Conditions are interned: creating a condition with
+-- the same clauses as an existing one, in any order, returns the existing instance.
+--
+-- @param clauses
+--    A table of field-pattern pairs representing the clauses of the condition.
+-- @return
+--    A new Condition instance representing the specified clauses.
+---
+
+function Condition.new(clauses)
+	local key = _clausesKey(clauses)
+	if key ~= nil then
+		local existing = _interned[key]
+		if existing ~= nil then
+			return existing
 		end
-		return false
+	end
 
+	local self = Type.assign(Condition, {
+		_fieldsTested = {},
+		_testedMask = {},
+		_rootTest = nil,
+		_evaluate = nil
+	})
+
+	local ok, result = pcall(function()
+		return Condition._parseCondition(self, clauses)
+	end)
+
+	if not ok then
+		error(result, 2)
 	end
 
-	return result
+	self._rootTest = result
+	self._evaluate = _compile(result)
+
+	if key ~= nil then
+		_interned[key] = self
+	end
+
+	return self
 end
 
 
@@ -118,6 +292,35 @@ function Condition.allFieldsTested()
 end
 
 
+---
+-- Returns the set of fields tested by this condition's clauses, as a table keyed
+-- by field.
+---
+
+function Condition.fieldsTested(self)
+	return self._fieldsTested
+end
+
+
+---
+-- Build the bitsets of the fields contained by each of a list of scopes. Queries
+-- which test many conditions against the same scopes can build these once, and pass
+-- them to `doesTestScopeValues()` and `matchesScopeAndValues()`.
+--
+-- Normally a condition must test every field of a scope to be in that scope. Fields in
+-- the optional `anyFields` set are the exception: a condition only needs to test one
+-- of them, ex. either the configuration or the platform of a `State.selectAny()`.
+---
+
+function Condition.scopeMasks(scopes, anyFields)
+	local result = {}
+	for i = 1, #scopes do
+		result[i] = _scopeMask(scopes[i], anyFields)
+	end
+	return result
+end
+
+
 ---
 -- Checks a list of scopes to see if any is fully tested by this condition.
 --
@@ -127,23 +330,17 @@ end
 --
 -- This test does not check to see if the scope's values pass the test, only that there
 -- *is* a test. Use `Condition.matchesScopeAndValues()` for a full test.
+--
+-- `scopeMasks` is an optional list of the scopes' bitsets, from `Condition.scopeMasks()`.
 ---
 
-function Condition.doesTestScopeValues(self, scopes)
-	local fieldsTested = self._fieldsTested
+function Condition.doesTestScopeValues(self, scopes, scopeMasks)
+	scopeMasks = scopeMasks or Condition.scopeMasks(scopes)
 
-	for i = 1, #scopes do
-		local scope = scopes[i]
-		local isScopeMatch = true
+	local testedMask = self._testedMask
 
-		for field in pairs(scope) do
-			if not fieldsTested[field] then
-				isScopeMatch = false
-				break
-			end
-		end
-
-		if isScopeMatch then
+	for i = 1, #scopes do
+		if _testsScope(testedMask, scopeMasks[i]) then
 			return true
 		end
 	end
@@ -168,26 +365,21 @@ end
 --    If `NIL_MATCHES_ANY` (true), a `nil` value in `scope` or `values` is treated like
 --    a wildcard which will match any value. If `NIL_MATCHES_NONE`, `nil` is treat normally,
 --    like a missing value which fails testing.
+-- @param scopeMasks
+--    An optional list of the scopes' field bitsets, from `Condition.scopeMasks()`.
 -- @returns
 --   If a match is found in the list of scopes, and the values pass the condition, returns
 --   the index of the matched scope. If no match is found, returns `nil`.
 ---
 
-function Condition.matchesScopeAndValues(self, values, scopes, matchOnNil)
-	local fieldsTested = self._fieldsTested
+function Condition.matchesScopeAndValues(self, values, scopes, matchOnNil, scopeMasks)
+	scopeMasks = scopeMasks or Condition.scopeMasks(scopes)
 
-	for i = 1, #scopes do
-		local scope = scopes[i]
-
-		local isScopeMatch = true
-		for field in pairs(scope) do
-			if not fieldsTested[field] then
-				isScopeMatch = false
-				break
-			end
-		end
+	local testedMask = self._testedMask
+	local evaluate = self._evaluate
 
-		if isScopeMatch and Condition.matchesValues(self, values, scope, matchOnNil) then
+	for i = 1, #scopes do
+		if _testsScope(testedMask, scopeMasks[i]) and evaluate(values, scopes[i], matchOnNil) then
 			return i
 		end
 	end
@@ -216,31 +408,264 @@ end
 ---
 
 function Condition.matchesValues(self, values, scope, matchOnNil)
-	local ok, result = pcall(_match, self._rootTest, values, scope, matchOnNil)
+	return self._evaluate(values, scope, matchOnNil)
+end
+
+
+---
+-- Three-valued evaluation of a tree of clauses: returns `true` or `false` if the provided values
+-- are enough to decide the test, or `nil` if the outcome depends on a field which was
+-- not provided.
+---
+
+local function _canMatch(operation, values)
+	local op = operation._op
+
+	if op == OP_MATCH then
+		local field = operation[1]
+		local testValue = values[field]
+		if testValue == nil then
+			return nil
+		end
+		return (Field.matches(field, testValue, operation[2], true) and true or false)
+
+	elseif op == OP_AND then
+		local result = true
+		for i = 1, #operation do
+			local test = _canMatch(operation[i], values)
+			if test == false then
+				return false
+			elseif test == nil then
+				result = nil
+			end
+		end
+		return result
+
+	elseif op == OP_OR then
+		local result = false
+		for i = 1, #operation do
+			local test = _canMatch(operation[i], values)
+			if test == true then
+				return true
+			elseif test == nil then
+				result = nil
+			end
+		end
+		return result
+
+	elseif op == OP_NOT then
+		local test = _canMatch(operation[1], values)
+		if test == nil then
+			return nil
+		end
+		return not test
 
-	if not ok then
-		error(result, 2)
 	end
+end
+
+
+---
+-- Tests whether this condition could possibly match, given values for only some of
+-- the fields it tests. Clauses on fields missing from `values` may go either way,
+-- so the condition is only ruled out if the provided values alone are enough to
+-- make it fail.
+--
+-- @param values
+--    A collection of field-value pairs, e.g. `{ [workspacesField]='W1' }`. Scope and
+--    non-scope fields are treated alike.
+-- @returns
+--    False if the condition can not match these values; true otherwise.
+---
+
+function Condition.canMatch(self, values)
+	return (_canMatch(self._rootTest, values) ~= false)
+end
+
+
+---
+-- Tests whether any of this condition's clauses on `field` would match `value`,
+-- without regard to the rest of the condition, or to whether the clause is negated.
+-- A value which matches none of the clauses on a field has no effect on any test
+-- of that field; see `State.selectEach()`.
+--
+-- @param field
+--    The field to check.
+-- @param value
+--    The value to check, as received by the field, e.g. `{ 'src/main.c' }`.
+-- @returns
+--    True if some clause on `field` matches the value; false otherwise.
+---
+
+local function _hasClauseMatching(operation, field, value)
+	local op = operation._op
+
+	if op == OP_MATCH then
+		return (operation[1] == field and Field.matches(field, value, operation[2], true))
+	end
+
+	for i = 1, #operation do
+		if _hasClauseMatching(operation[i], field, value) then
+			return true
+		end
+	end
+
+	return false
+end
 
+
+function Condition.hasClauseMatching(self, field, value)
+	if not self._fieldsTested[field] then
+		return false
+	end
+	return (_hasClauseMatching(self._rootTest, field, value) and true or false)
+end
+
+
+---
+-- Returns the scope values which this condition requires in order to match: one
+-- `{ field, value }` pair for each top-level clause which tests a scope field for
+-- an exact value, e.g. `projects = 'MyProject'`. Clauses which are negated or
+-- OR-ed with others are not included, as they can match without the value.
+---
+
+local function _collectRequiredScopeValues(operation, result)
+	local op = operation._op
+
+	if op == OP_AND then
+		for i = 1, #operation do
+			_collectRequiredScopeValues(operation[i], result)
+		end
+	elseif op == OP_MATCH then
+		local field = operation[1]
+		-- plain string clauses match exact values; paths are normalized on the fly
+		if field.isScope and string.find(field.kind, 'string$') then
+			table.insert(result, { field, operation[2] })
+		end
+	end
+end
+
+
+function Condition.requiredScopeValues(self)
+	local result = self._requiredScopeValues
+	if result == nil then
+		result = {}
+		_collectRequiredScopeValues(self._rootTest, result)
+		self._requiredScopeValues = result
+	end
 	return result
 end
 
 
 ---
--- Merges conditions by AND-ing all of the clauses together.
+-- Returns a hash of the condition's clauses. Fields are identified by name, so the
+-- result is stable from one run to the next.
 ---
 
-function Condition.merge(left, right)
-	local fieldsTested = table.mergeKeys(left._fieldsTested, right._fieldsTested)
-	local rootTest = {
-		_op = OP_AND,
-		left._rootTest, right._rootTest
-	}
+local function _serialize(operation)
+	if operation._op == OP_MATCH then
+		return { OP_MATCH, operation[1].name, operation[2] }
+	end
+
+	local result = { operation._op }
+	for i = 1, #operation do
+		result[i + 1] = _serialize(operation[i])
+	end
+	return result
+end
+
+
+function Condition.hash(self)
+	local hash = self._hash
+	if hash == nil then
+		hash = table.hash(_serialize(self._rootTest))
+		self._hash = hash
+	end
+	return hash
+end
 
-	return Type.assign(Condition, {
-		_fieldsTested = fieldsTested,
-		_rootTest = rootTest
+
+---
+-- Returns the condition's clauses as a tree of plain values, with fields identified by
+-- name: `{ 'MATCH', fieldName, pattern }` for a single test, or an operator followed by
+-- its operands, e.g. `{ 'AND', { 'MATCH', 'kind', 'StaticLib' }, ... }`. The tree can be
+-- saved and passed to `Condition.fromTree()` to rebuild the condition in a later run.
+---
+
+function Condition.toTree(self)
+	return _serialize(self._rootTest)
+end
+
+
+local function _deserialize(self, tree)
+	local op = tree[1]
+
+	if op == OP_MATCH then
+		local field = Field.get(tree[2])
+		self._fieldsTested[field] = true
+		_setBit(self._testedMask, field.id)
+		_allFieldsTested[field] = true
+		return { _op = OP_MATCH, field, tree[3] }
+	end
+
+	local operation = { _op = op }
+	for i = 2, #tree do
+		operation[i - 1] = _deserialize(self, tree[i])
+	end
+	return operation
+end
+
+
+---
+-- Rebuild a condition from a tree returned by `Condition.toTree()`. Raises an error if
+-- the tree tests a field which has not been registered.
+---
+
+function Condition.fromTree(tree)
+	local self = Type.assign(Condition, {
+		_fieldsTested = {},
+		_testedMask = {},
+		_rootTest = nil,
+		_evaluate = nil
 	})
+
+	self._rootTest = _deserialize(self, tree)
+	self._evaluate = _compile(self._rootTest)
+	return self
+end
+
+
+---
+-- Merges conditions by AND-ing all of the clauses together. Merging the same pair of
+-- conditions again returns the same instance.
+---
+
+function Condition.merge(left, right)
+	local mergedWithLeft = _merged[left]
+	if mergedWithLeft == nil then
+		mergedWithLeft = setmetatable({}, { __mode = 'k' })
+		_merged[left] = mergedWithLeft
+	end
+
+	local result = mergedWithLeft[right]
+	if result == nil then
+		local fieldsTested = table.mergeKeys(left._fieldsTested, right._fieldsTested)
+		local testedMask = _unionMasks(left._testedMask, right._testedMask)
+		local rootTest = {
+			_op = OP_AND,
+			left._rootTest, right._rootTest
+		}
+
+		result = Type.assign(Condition, {
+			_fieldsTested = fieldsTested,
+			_testedMask = testedMask,
+			_rootTest = rootTest,
+			_evaluate = _compile(rootTest)
+		})
+
+		mergedWithLeft[right] = result
+	end
+
+	return result
 end
 
 
@@ -285,6 +710,7 @@ function Condition._parseClause(self, defaultFieldName, fieldName, pattern)
 	-- we've reduced it to a simple 'key=value' test
 	local field = Field.get(fieldName)
 	self._fieldsTested[field] = true
+	_setBit(self._testedMask, field.id)
 	_allFieldsTested[field] = true
 	return { _op = OP_MATCH, field, pattern }
 end
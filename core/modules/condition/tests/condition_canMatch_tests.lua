@@ -0,0 +1,91 @@
+local Condition = require('condition')
+local Field = require('field')
+local set = require('set')
+
+local ConditionCanMatchTests = test.declare('ConditionCanMatchTests', 'condition')
+
+local _PROJECTS = Field.get('projects')
+local _WORKSPACES = Field.get('workspaces')
+
+local _values = {
+	[_WORKSPACES] = set.of('Workspace1'),
+	[_PROJECTS] = set.of('Project1')
+}
+
+
+function ConditionCanMatchTests.isTrue_onEmptyCondition()
+	local cond = Condition.new({})
+	test.isTrue(cond:canMatch(_values))
+end
+
+
+function ConditionCanMatchTests.isTrue_onMatchingValues()
+	local cond = Condition.new({ workspaces = 'Workspace1', projects = 'Project1' })
+	test.isTrue(cond:canMatch(_values))
+end
+
+
+function ConditionCanMatchTests.isFalse_onMismatchedValue()
+	local cond = Condition.new({ workspaces = 'Workspace1', projects = 'Project2' })
+	test.isFalse(cond:canMatch(_values))
+end
+
+
+function ConditionCanMatchTests.isTrue_onUnknownField()
+	local cond = Condition.new({ projects = 'Project1', configurations = 'Debug' })
+	test.isTrue(cond:canMatch(_values))
+end
+
+
+function ConditionCanMatchTests.isTrue_onNegatedUnknownField()
+	local cond = Condition.new({ projects = 'Project1', configurations = 'not Debug' })
+	test.isTrue(cond:canMatch(_values))
+end
+
+
+function ConditionCanMatchTests.isFalse_onNegatedKnownField()
+	local cond = Condition.new({ projects = 'not Project1' })
+	test.isFalse(cond:canMatch(_values))
+end
+
+
+function ConditionCanMatchTests.isTrue_onOrWithUnknownField()
+	local cond = Condition.new({ 'projects:Project2 or configurations:Debug' })
+	test.isTrue(cond:canMatch(_values))
+end
+
+
+function ConditionCanMatchTests.isFalse_onMergedConditionWithMismatch()
+	local outer = Condition.new({ workspaces = 'Workspace1' })
+	local inner = Condition.new({ projects = 'Project2' })
+	test.isFalse(Condition.merge(outer, inner):canMatch(_values))
+end
+
+
+---
+-- `hasClauseMatching()` looks at each clause on the field alone, ignoring negation and
+-- the rest of the condition.
+---
+
+function ConditionCanMatchTests.hasClauseMatching_isTrue_onMatchingClause()
+	local cond = Condition.new({ projects = 'Project1', configurations = 'Debug' })
+	test.isTrue(cond:hasClauseMatching(_PROJECTS, _values[_PROJECTS]))
+end
+
+
+function ConditionCanMatchTests.hasClauseMatching_isTrue_onNegatedClause()
+	local cond = Condition.new({ projects = 'not Project1' })
+	test.isTrue(cond:hasClauseMatching(_PROJECTS, _values[_PROJECTS]))
+end
+
+
+function ConditionCanMatchTests.hasClauseMatching_isFalse_onOtherValue()
+	local cond = Condition.new({ 'projects:Project2 or workspaces:Workspace1' })
+	test.isFalse(cond:hasClauseMatching(_PROJECTS, _values[_PROJECTS]))
+end
+
+
+function ConditionCanMatchTests.hasClauseMatching_isFalse_onUntestedField()
+	local cond = Condition.new({ workspaces = 'Workspace1' })
+	test.isFalse(cond:hasClauseMatching(_PROJECTS, _values[_PROJECTS]))
+end
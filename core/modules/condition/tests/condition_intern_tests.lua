@@ -0,0 +1,46 @@
+local Condition = require('condition')
+
+local ConditionInternTests = test.declare('ConditionInternTests', 'condition')
+
+
+---
+-- Conditions with the same clauses should share a single instance.
+---
+
+function ConditionInternTests.new_returnsSameInstance_onSameClauses()
+	local cond1 = Condition.new({ system = 'Windows', kind = 'SharedLibrary' })
+	local cond2 = Condition.new({ kind = 'SharedLibrary', system = 'Windows' })
+	test.isTrue(cond1 == cond2)
+end
+
+
+function ConditionInternTests.new_returnsSameInstance_onSameStringClauses()
+	local cond1 = Condition.new({ 'system:Windows', 'kind:SharedLibrary' })
+	local cond2 = Condition.new({ 'kind:SharedLibrary', 'system:Windows' })
+	test.isTrue(cond1 == cond2)
+end
+
+
+function ConditionInternTests.new_returnsNewInstance_onDifferentClauses()
+	local cond1 = Condition.new({ system = 'Windows' })
+	local cond2 = Condition.new({ system = 'MacOS' })
+	test.isFalse(cond1 == cond2)
+end
+
+
+---
+-- Merging the same pair of conditions should return the same instance.
+---
+
+function ConditionInternTests.merge_returnsSameInstance_onSameConditions()
+	local outer = Condition.new({ workspaces = 'Workspace1' })
+	local inner = Condition.new({ projects = 'Project1' })
+	test.isTrue(Condition.merge(outer, inner) == Condition.merge(outer, inner))
+end
+
+
+function ConditionInternTests.merge_returnsNewInstance_onReversedConditions()
+	local outer = Condition.new({ workspaces = 'Workspace1' })
+	local inner = Condition.new({ projects = 'Project1' })
+	test.isFalse(Condition.merge(outer, inner) == Condition.merge(inner, outer))
+end
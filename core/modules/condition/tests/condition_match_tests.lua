@@ -130,3 +130,100 @@ function ConditionMatchTests.valueField_fails_onValueNotSet()
 		{}
 	))
 end
+
+
+---
+-- Operators should be honored by the compiled evaluator.
+---
+
+function ConditionMatchTests.or_matches_onEitherValue()
+	local cond = Condition.new({ defines = 'X or Y' })
+
+	test.isTrue(cond:matchesValues(
+		{ [_DEFINES] = set.of('Y') },
+		{}
+	))
+end
+
+
+function ConditionMatchTests.or_fails_onNeitherValue()
+	local cond = Condition.new({ defines = 'X or Y' })
+
+	test.isFalse(cond:matchesValues(
+		{ [_DEFINES] = set.of('Z') },
+		{}
+	))
+end
+
+
+function ConditionMatchTests.not_matches_onOtherValue()
+	local cond = Condition.new({ defines = 'not X' })
+
+	test.isTrue(cond:matchesValues(
+		{ [_DEFINES] = set.of('Y') },
+		{}
+	))
+end
+
+
+function ConditionMatchTests.not_fails_onMatchingValue()
+	local cond = Condition.new({ defines = 'not X' })
+
+	test.isFalse(cond:matchesValues(
+		{ [_DEFINES] = set.of('X') },
+		{}
+	))
+end
+
+
+---
+-- Merged conditions should require all of the clauses from both sides.
+---
+
+function ConditionMatchTests.merged_matches_onAllClauses()
+	local cond = Condition.merge(Condition.new({ workspaces = 'Workspace1' }), Condition.new({ defines = 'X' }))
+
+	test.isTrue(cond:matchesValues(
+		{ [_DEFINES] = set.of('X') },
+		{ [_WORKSPACES] = set.of('Workspace1') }
+	))
+end
+
+
+function ConditionMatchTests.merged_fails_onOneClause()
+	local cond = Condition.merge(Condition.new({ workspaces = 'Workspace1' }), Condition.new({ defines = 'X' }))
+
+	test.isFalse(cond:matchesValues(
+		{ [_DEFINES] = set.of('Y') },
+		{ [_WORKSPACES] = set.of('Workspace1') }
+	))
+end
+
+
+---
+-- Missing values should be treated as wildcards when requested.
+---
+
+function ConditionMatchTests.valueField_matches_onValueNotSet_withNilMatchesAny()
+	local cond = Condition.new({ defines = 'X' })
+
+	test.isTrue(cond:matchesValues(
+		{},
+		{},
+		Condition.NIL_MATCHES_ANY
+	))
+end
+
+
+---
+-- Conditions with the same shape share compiled code, but must still test their own
+-- patterns.
+---
+
+function ConditionMatchTests.sameShape_usesOwnPatterns()
+	local cond1 = Condition.new({ defines = 'X' })
+	local cond2 = Condition.new({ defines = 'Y' })
+
+	test.isTrue(cond1:matchesValues({ [_DEFINES] = set.of('X') }, {}))
+	test.isFalse(cond2:matchesValues({ [_DEFINES] = set.of('X') }, {}))
+end
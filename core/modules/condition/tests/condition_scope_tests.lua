@@ -0,0 +1,78 @@
+local Condition = require('condition')
+local Field = require('field')
+local set = require('set')
+
+local ConditionScopeTests = test.declare('ConditionScopeTests', 'condition')
+
+local _PROJECTS = Field.get('projects')
+local _WORKSPACES = Field.get('workspaces')
+
+
+---
+-- A condition tests a scope if it has clauses for every field in the scope.
+---
+
+function ConditionScopeTests.doesTestScopeValues_isTrue_onAllFieldsTested()
+	local cond = Condition.new({ workspaces = 'Workspace1', projects = 'Project1' })
+	test.isTrue(cond:doesTestScopeValues({
+		{ [_WORKSPACES] = set.of('Workspace1'), [_PROJECTS] = set.of('Project1') }
+	}))
+end
+
+
+function ConditionScopeTests.doesTestScopeValues_isFalse_onUntestedField()
+	local cond = Condition.new({ workspaces = 'Workspace1' })
+	test.isFalse(cond:doesTestScopeValues({
+		{ [_WORKSPACES] = set.of('Workspace1'), [_PROJECTS] = set.of('Project1') }
+	}))
+end
+
+
+function ConditionScopeTests.doesTestScopeValues_isTrue_onEmptyScope()
+	local cond = Condition.new({ workspaces = 'Workspace1' })
+	test.isTrue(cond:doesTestScopeValues({ _EMPTY }))
+end
+
+
+---
+-- `matchesScopeAndValues()` should return the index of the first matching scope.
+---
+
+function ConditionScopeTests.matchesScopeAndValues_returnsIndexOfMatch()
+	local cond = Condition.new({ projects = 'Project1' })
+	test.isEqual(2, cond:matchesScopeAndValues({}, {
+		{ [_WORKSPACES] = set.of('Workspace1') },
+		{ [_PROJECTS] = set.of('Project1') }
+	}))
+end
+
+
+function ConditionScopeTests.matchesScopeAndValues_usesProvidedMasks()
+	local cond = Condition.new({ projects = 'Project1' })
+	local scopes = { { [_PROJECTS] = set.of('Project1') } }
+	test.isEqual(1, cond:matchesScopeAndValues({}, scopes, nil, Condition.scopeMasks(scopes)))
+end
+
+
+---
+-- Field sets span multiple words once there are more than 64 fields.
+---
+
+function ConditionScopeTests.doesTestScopeValues_handlesHighFieldIds()
+	local fields = {}
+	for i = 1, 70 do
+		fields[i] = Field.register({ name = 'scopeTestField' .. i, kind = 'string' })
+	end
+
+	local lastField = fields[70]
+	local cond = Condition.new({ scopeTestField70 = 'X' })
+	local tests = cond:doesTestScopeValues({ { [lastField] = 'X' } })
+	local testsOther = cond:doesTestScopeValues({ { [lastField] = 'X', [_PROJECTS] = set.of('Project1') } })
+
+	for i = 1, #fields do
+		Field.remove(fields[i])
+	end
+
+	test.isTrue(tests)
+	test.isFalse(testsOther)
+end
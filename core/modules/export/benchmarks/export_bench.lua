@@ -0,0 +1,64 @@
+---
+-- Measure the per-line cost of the export writers, which sit in the innermost
+-- loop of every exporter.
+---
+
+local export = require('export')
+
+local ExportBench = bench.declare('ExportBench')
+
+
+function ExportBench.writeLine_100()
+	export.capture(function()
+		export.indent(2)
+		for i = 1, 100 do
+			export.writeLine('<ClCompile Include="%s" />', 'src\\file.cpp')
+		end
+	end)
+end
+
+
+function ExportBench.writeLine_nestedIndent_100()
+	export.capture(function()
+		for i = 1, 25 do
+			export.writeLine('<ItemGroup>')
+			export.indent()
+			export.writeLine('<Filter>%s</Filter>', 'Source Files')
+			export.writeLine('<Id>%d</Id>', i)
+			export.outdent()
+			export.writeLine('</ItemGroup>')
+		end
+	end)
+end
+
+
+local function _fileSettings()
+	export.indent()
+	export.writeLine('<ObjectFileName Condition="%s">$(IntDir)%s.obj</ObjectFileName>', 'Debug|Win32', 'file')
+	export.writeLine('<ObjectFileName Condition="%s">$(IntDir)%s.obj</ObjectFileName>', 'Release|Win32', 'file')
+	export.outdent()
+end
+
+
+function ExportBench.perFileCapture_string_25()
+	export.capture(function()
+		for i = 1, 25 do
+			local settings = export.capture(_fileSettings)
+			export.writeLine('<ClCompile Include="%s">', 'file.cpp')
+			export.appendLine('%s', settings)
+			export.writeLine('</ClCompile>')
+		end
+	end)
+end
+
+
+function ExportBench.perFileCapture_splice_25()
+	export.capture(function()
+		for i = 1, 25 do
+			local settings = export.captureBuffer(_fileSettings)
+			export.writeLine('<ClCompile Include="%s">', 'file.cpp')
+			export.splice(settings)
+			export.writeLine('</ClCompile>')
+		end
+	end)
+end
@@ -3,47 +3,154 @@ local Buffer = require('buffer')
 local export = {}
 
 local _captureBuffer
-local _eol = '\n'
-local _indentLevel = 0
-local _indentString = '\t'
+
+-- Amount of output held in memory while streaming to a file
+local _streamChunkSize = 64 * 1024
+
+-- Holds the end-of-line, indent string, and indent level while no capture is active;
+-- each capture starts from a copy of whatever buffer encloses it
+local _settings = Buffer.new()
+
+-- Capture buffers which have been released, kept for reuse by later captures
+local _pool = {}
+local _poolSize = 0
+
+
+local function _current()
+	return _captureBuffer or _settings
+end
+
+
+local function _acquire(capacity)
+	local b
+	if _poolSize > 0 then
+		b = _pool[_poolSize]
+		_pool[_poolSize] = nil
+		_poolSize = _poolSize - 1
+		Buffer.reset(b, _current())
+		if capacity then
+			Buffer.reserve(b, capacity)
+		end
+	else
+		b = Buffer.new(capacity, _current())
+	end
+	return b
+end
+
+
+local function _release(b)
+	_poolSize = _poolSize + 1
+	_pool[_poolSize] = b
+end
 
 
 function export.append(...)
 	if _captureBuffer == nil then
 		error('no active capture', 0)
 	end
-
-	if select('#', ...) > 0 then
-		Buffer.write(_captureBuffer, string.format(...))
-	end
+	Buffer.appendf(_captureBuffer, ...)
 end
 
 
 function export.appendLine(...)
-	export.append(...)
-	Buffer.write(_captureBuffer, _eol)
+	if _captureBuffer == nil then
+		error('no active capture', 0)
+	end
+	Buffer.appendLinef(_captureBuffer, ...)
 end
 
 
-function export.capture(fn)
+---
+-- Capture the output of a function into a string.
+--
+-- @param fn
+--    The function to be captured; any output written via `export.write()` and friends
+--    during the call is collected into the result.
+-- @param capacity
+--    An optional estimate of the size of the output, in bytes. If provided, the capture
+--    buffer is allocated at that size up front instead of growing as it goes.
+-- @returns
+--    The captured output, with any trailing end-of-line removed.
+---
+
+function export.capture(fn, capacity)
 	local oldBuffer = _captureBuffer
-	local oldEol = _eol
-	local oldLevel = _indentLevel
-	local oldIndent = _indentString
 
-	_captureBuffer = Buffer.new()
+	-- Formatting changes made during the capture stay with its buffer, so the
+	-- enclosing settings come back untouched when it is released
+	_captureBuffer = _acquire(capacity)
 
 	fn()
-	local result = Buffer.close(_captureBuffer)
+	local result = Buffer.toString(_captureBuffer)
+	_release(_captureBuffer)
 
-	_indentString = oldIndent
-	_indentLevel = oldLevel
-	_eol = oldEol
 	_captureBuffer = oldBuffer
 	return result
 end
 
 
+---
+-- Capture the output of a function, but hold on to it as a buffer rather than
+-- converting it to a string. Use `export.splice()` to write it into the enclosing
+-- capture once any surrounding markup is in place.
+--
+-- @param fn
+--    The function to be captured.
+-- @returns
+--    A buffer holding the captured output, or `nil` if nothing was written. The
+--    buffer must be handed back via `export.splice()`.
+---
+
+function export.captureBuffer(fn)
+	local oldBuffer = _captureBuffer
+	_captureBuffer = _acquire()
+
+	fn()
+	local result = _captureBuffer
+	_captureBuffer = oldBuffer
+
+	if Buffer.isEmpty(result) then
+		_release(result)
+		return nil
+	end
+
+	return result
+end
+
+
+---
+-- Stream the output of a function to a file. Output is compared against the file's
+-- existing contents a chunk at a time as it is produced; the file is only replaced,
+-- via a temporary file, if the new output differs. Memory use is bounded by the chunk
+-- size rather than the size of the file.
+--
+-- @param exportPath
+--    The path of the file to write.
+-- @param fn
+--    The function producing the output.
+-- @param chunkSize
+--    An optional size in bytes for each chunk of output; defaults to 64K.
+-- @returns
+--    True if the file was written, false if it already held the same output.
+---
+
+function export.stream(exportPath, fn, chunkSize)
+	local oldBuffer = _captureBuffer
+	_captureBuffer = _acquire()
+	Buffer.stream(_captureBuffer, exportPath, chunkSize or _streamChunkSize)
+
+	fn()
+	local updated = Buffer.finish(_captureBuffer)
+	_release(_captureBuffer)
+
+	_captureBuffer = oldBuffer
+	if updated == nil then
+		error(string.format("unable to write file to '%s'", exportPath), 0)
+	end
+	return updated
+end
+
+
 function export.captured()
 	if _captureBuffer then
 		return Buffer.toString(_captureBuffer)
@@ -54,27 +161,37 @@ end
 
 
 function export.eol(value)
-	_eol = value or _eol
-	return _eol
+	return Buffer.eol(_current(), value)
 end
 
 
 function export.indent(amount)
-	_indentLevel = _indentLevel + (amount or 1)
+	Buffer.indent(_current(), amount or 1)
+end
+
+
+---
+-- Write the output held by a buffer from `export.captureBuffer()` into the active
+-- capture, followed by an end-of-line. The contents are copied directly between
+-- buffers, and the captured buffer is returned to the pool for reuse.
+---
+
+function export.splice(captured)
+	if _captureBuffer == nil then
+		error('no active capture', 0)
+	end
+	Buffer.splice(_captureBuffer, captured)
+	_release(captured)
 end
 
 
 function export.indentString(value)
-	_indentString = value or _indentString
-	return _indentString
+	return Buffer.indentString(_current(), value)
 end
 
 
 function export.outdent(amount)
-	_indentLevel = _indentLevel - (amount or 1)
-	if _indentLevel < 0 then
-		_indentLevel = 0
-	end
+	Buffer.indent(_current(), -(amount or 1))
 end
 
 
@@ -87,21 +204,31 @@ function export.writeUtf8Bom()
 end
 
 
+---
+-- Write a line fragment: the current indentation, followed by the text produced by
+-- passing the arguments to `string.format()`. Writes nothing if called without
+-- arguments.
+---
+
 function export.write(...)
 	if _captureBuffer == nil then
 		error('no active capture', 0)
 	end
-
-	if select('#', ...) > 0 then
-		Buffer.write(_captureBuffer, string.rep(_indentString, _indentLevel))
-		Buffer.write(_captureBuffer, string.format(...))
-	end
+	Buffer.writef(_captureBuffer, ...)
 end
 
 
+---
+-- Write a full line: the current indentation, the formatted text, and the current
+-- end-of-line sequence, in a single call into the buffer. Writes a blank line if
+-- called without arguments.
+---
+
 function export.writeLine(...)
-	export.write(...)
-	Buffer.write(_captureBuffer, _eol)
+	if _captureBuffer == nil then
+		error('no active capture', 0)
+	end
+	Buffer.writeLinef(_captureBuffer, ...)
 end
 
 
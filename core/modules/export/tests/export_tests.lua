@@ -18,3 +18,145 @@ function ExportTests.indent_prependsIndentString()
 	end)
 	test.isEqual('\tmessage goes here', result)
 end
+
+
+function ExportTests.writeLine_usesEolAndIndentString()
+	local result = export.capture(function()
+		export.eol('\r\n')
+		export.indentString('  ')
+		export.writeLine('<%s>', 'a')
+		export.indent()
+		export.writeLine('<%s/>', 'b')
+		export.outdent()
+		export.writeLine('</%s>', 'a')
+	end)
+	test.isEqual('<a>\r\n  <b/>\r\n</a>', result)
+end
+
+
+function ExportTests.capture_inheritsAndRestoresFormatting()
+	local inner
+	local outer = export.capture(function()
+		export.indent()
+		inner = export.capture(function()
+			export.indent()
+			export.write('inner')
+		end)
+		export.write('outer')
+	end)
+	test.isEqual('\t\tinner', inner)
+	test.isEqual('\touter', outer)
+end
+
+
+function ExportTests.captureBuffer_returnsNil_onNoOutput()
+	local result
+	export.capture(function()
+		result = export.captureBuffer(function() end)
+	end)
+	test.isNil(result)
+end
+
+
+function ExportTests.splice_writesCapturedOutputAsLine()
+	local result = export.capture(function()
+		export.writeLine('<Outer>')
+		local inner = export.captureBuffer(function()
+			export.indent()
+			export.writeLine('<Inner>%s</Inner>', '100%')
+		end)
+		export.splice(inner)
+		export.writeLine('</Outer>')
+	end)
+	test.isEqual('<Outer>\n\t<Inner>100%</Inner>\n</Outer>', result)
+end
+
+
+function ExportTests.capture_reusesReleasedBuffers_withFreshFormatting()
+	export.capture(function()
+		export.eol('\r\n')
+		export.indent(3)
+		export.write('x')
+	end)
+	local result = export.capture(function()
+		export.writeLine('y')
+		export.write('z')
+	end)
+	test.isEqual('y\nz', result)
+end
+
+
+---
+-- Streaming output to a file; small chunk sizes are used to exercise the flushes.
+---
+
+local function _streamLines(exportPath, lines)
+	return export.stream(exportPath, function()
+		for i = 1, #lines do
+			export.writeLine(lines[i])
+		end
+	end, 8)
+end
+
+
+local function _readFile(exportPath)
+	local file = io.open(exportPath, 'rb')
+	local contents = file:read('a')
+	file:close()
+	return contents
+end
+
+
+function ExportTests.stream_writesNewFile_withoutTrailingEol()
+	local exportPath = os.tmpname()
+	os.remove(exportPath)
+	test.isTrue(_streamLines(exportPath, { 'first line', 'second line' }))
+	test.isEqual('first line\nsecond line', _readFile(exportPath))
+	os.remove(exportPath)
+end
+
+
+function ExportTests.stream_returnsFalse_onSameOutput()
+	local exportPath = os.tmpname()
+	_streamLines(exportPath, { 'first line', 'second line' })
+	test.isFalse(_streamLines(exportPath, { 'first line', 'second line' }))
+	os.remove(exportPath)
+end
+
+
+function ExportTests.stream_rewritesFile_onChangedOutput()
+	local exportPath = os.tmpname()
+	_streamLines(exportPath, { 'first line', 'second line' })
+	test.isTrue(_streamLines(exportPath, { 'first line', 'changed line' }))
+	test.isEqual('first line\nchanged line', _readFile(exportPath))
+	os.remove(exportPath)
+end
+
+
+function ExportTests.stream_truncatesFile_onShorterOutput()
+	local exportPath = os.tmpname()
+	_streamLines(exportPath, { 'first line', 'second line' })
+	test.isTrue(_streamLines(exportPath, { 'first line' }))
+	test.isEqual('first line', _readFile(exportPath))
+	os.remove(exportPath)
+end
+
+
+function ExportTests.stream_extendsFile_onLongerOutput()
+	local exportPath = os.tmpname()
+	_streamLines(exportPath, { 'first line' })
+	test.isTrue(_streamLines(exportPath, { 'first line', 'second line' }))
+	test.isEqual('first line\nsecond line', _readFile(exportPath))
+	os.remove(exportPath)
+end
+
+
+function ExportTests.stream_writesFile_afterLargeCapture()
+	export.capture(function()
+		export.write(string.rep('x', 100000))
+	end)
+	local exportPath = os.tmpname()
+	test.isTrue(_streamLines(exportPath, { 'first line', 'second line' }))
+	test.isEqual('first line\nsecond line', _readFile(exportPath))
+	os.remove(exportPath)
+end
@@ -0,0 +1,80 @@
+---
+-- Measure building up and trimming down large collection values, as queries do when
+-- collecting `defines` or `files` from many blocks.
+---
+
+local Field = require('field')
+
+local FieldBench = bench.declare('FieldBench')
+
+local _BLOCK_COUNT = 200
+local _VALUES_PER_BLOCK = 20
+
+local _DEFINES = Field.get('defines')
+
+local _listField
+local _blockValues
+local _removePatterns
+
+
+function FieldBench.setup()
+	_listField = Field.register({
+		name = 'benchList',
+		kind = 'list:string'
+	})
+
+	_blockValues = {}
+	for i = 1, _BLOCK_COUNT do
+		local values = {}
+		for j = 1, _VALUES_PER_BLOCK do
+			table.insert(values, 'VALUE_' .. i .. '_' .. j)
+		end
+		_blockValues[i] = values
+	end
+
+	_removePatterns = {}
+	for i = 1, _BLOCK_COUNT, 2 do
+		table.insert(_removePatterns, 'VALUE_' .. i .. '_1')
+	end
+end
+
+
+function FieldBench.teardown()
+	Field.remove(_listField)
+end
+
+
+function FieldBench.mergeList()
+	local result
+	for i = 1, #_blockValues do
+		result = Field.mergeValues(_listField, result, _blockValues[i])
+	end
+	return result
+end
+
+
+function FieldBench.mergeSet()
+	local result
+	for i = 1, #_blockValues do
+		result = Field.mergeValues(_DEFINES, result, _blockValues[i])
+	end
+	return result
+end
+
+
+function FieldBench.mergeSet_removeMany()
+	local result
+	for i = 1, #_blockValues do
+		result = Field.mergeValues(_DEFINES, result, _blockValues[i])
+	end
+	return Field.removeValues(_DEFINES, result, _removePatterns)
+end
+
+
+function FieldBench.mergeList_removeMany()
+	local result
+	for i = 1, #_blockValues do
+		result = Field.mergeValues(_listField, result, _blockValues[i])
+	end
+	return Field.removeValues(_listField, result, _removePatterns)
+end
@@ -11,6 +11,7 @@ local Type = require('type')
 local Field = Type.declare('Field')
 
 local _registeredFields = {}
+local _nextFieldId = 1
 
 local _onFieldAddedCallbacks = {}
 local _onFieldRemovedCallbacks = {}
@@ -18,6 +19,7 @@ local _onFieldRemovedCallbacks = {}
 local _processors = {
 	default = {},
 	merge = {},
+	new = {},
 	pattern = {},
 	receive = {},
 	remove = {},
@@ -88,6 +90,9 @@ end
 --               can be chained together to create more complex types, such as
 --               "list:string".
 --
+-- Each field is also given a unique integer `id`, allocated densely from 1, for use
+-- in bitsets of fields.
+--
 -- @return
 --    A populated field object. Or nil and an error message if the field could
 --    not be registered.
@@ -103,6 +108,9 @@ function Field.register(definition)
 		end
 	end
 
+	field.id = _nextFieldId
+	_nextFieldId = _nextFieldId + 1
+
 	_registeredFields[field.name] = field
 
 	for i = 1, #_onFieldAddedCallbacks do
@@ -134,7 +142,7 @@ end
 --    The name of the field kind, ex. "string".
 -- @param operations
 --    A table of name-function pairs to handle the field operations: 'default',
---    'match', 'merge', 'remove'.
+--    'match', 'merge', 'new', 'pattern', 'receive', 'remove'.
 -- @returns
 --    True if successful, or `nil` and an error message if functions are not
 --    provided for all operations.
@@ -230,6 +238,21 @@ function Field.mergeValues(self, currentValue, newValues)
 end
 
 
+---
+-- Create a new, empty value for the field, with room for `size` values. A value which is
+-- about to be built up from many blocks can be sized up front, so that merging into it
+-- never has to grow it.
+--
+-- @returns
+--    For strings and other simple object types, returns `nil`. For lists and other
+--    collection types, returns an empty collection.
+---
+
+function Field.newValue(self, size)
+	return _processors.new[self.kind](self, size)
+end
+
+
 ---
 -- Register a callback function to be notified when a new field is added.
 ---
@@ -291,25 +314,97 @@ function Field.receiveAllValues(...)
 end
 
 
+---
+-- Put values removed by `removeValues()` into the order of the patterns which removed
+-- them. Values are sorted into one bucket per pattern position, keeping their order
+-- within each bucket, so the cost is linear in the number of values.
+---
+
+local function _sortByPattern(self, removedValues, plainPatterns, wildcardPatterns, wildcardPositions)
+	local matchValues = _processors.match[self.kind]
+
+	local buckets = {}
+	local maxPosition = 0
+
+	for i = 1, #removedValues do
+		local value = removedValues[i]
+
+		local position = plainPatterns[value]
+		for j = 1, #wildcardPatterns do
+			if position ~= nil and position < wildcardPositions[j] then
+				break
+			end
+			if matchValues(self, { value }, wildcardPatterns[j], false) then
+				position = wildcardPositions[j]
+				break
+			end
+		end
+
+		local bucket = buckets[position]
+		if bucket == nil then
+			bucket = {}
+			buckets[position] = bucket
+			if position > maxPosition then
+				maxPosition = position
+			end
+		end
+		bucket[#bucket + 1] = value
+	end
+
+	local n = 0
+	for position = 1, maxPosition do
+		local bucket = buckets[position]
+		if bucket ~= nil then
+			for i = 1, #bucket do
+				n = n + 1
+				removedValues[n] = bucket[i]
+			end
+		end
+	end
+end
+
+
 ---
 -- Remove value(s) from a field.
+--
+-- All of the patterns are expanded up front, so the values can be compacted in a
+-- single pass no matter how many patterns are given. Plain patterns are collected into
+-- a set, which can be checked with a single lookup per value.
+--
+-- The removed values are returned in the order of the patterns which removed them, as
+-- if each pattern had been removed in turn; values removed by the same pattern keep
+-- their original order.
 ---
 
 function Field.removeValues(self, currentValue, patterns)
-	local allRemovedValues = {}
-
-	local removeValues = _processors.remove[self.kind]
 	local expandPattern = _processors.pattern[self.kind]
 
+	-- Each plain pattern maps to the position of its first appearance in `patterns`
+	local plainPatterns = {}
+	local wildcardPatterns = {}
+	local wildcardPositions = {}
+	local patternCount = 0
+
 	array.forEachFlattened(patterns, function (pattern)
-		if plain == nil then
-			pattern, plain = expandPattern(self, pattern)
+		local plain
+		pattern, plain = expandPattern(self, pattern)
+		patternCount = patternCount + 1
+		if not plain then
+			table.insert(wildcardPatterns, pattern)
+			table.insert(wildcardPositions, patternCount)
+		elseif plainPatterns[pattern] == nil then
+			plainPatterns[pattern] = patternCount
 		end
-		currentValue, removedValues = removeValues(self, currentValue, pattern, plain)
-		array.appendArrays(allRemovedValues, removedValues)
 	end)
 
-	return currentValue, allRemovedValues
+	local removedValues
+	currentValue, removedValues = _processors.remove[self.kind](self, currentValue, plainPatterns, wildcardPatterns)
+
+	if patternCount > 1 and #removedValues > 1 then
+		_sortByPattern(self, removedValues, plainPatterns, wildcardPatterns, wildcardPositions)
+	end
+
+	return currentValue, removedValues
 end
 
 
@@ -40,8 +40,18 @@ local function merge(field, inner, currentValue, newValue)
 end
 
 
+local function new()
+	return nil
+end
+
+
 local function pattern(field, inner, pattern)
-	return path.expandWildcards(pattern)
+	local plain
+	pattern, plain = path.expandWildcards(pattern)
+	if plain then
+		pattern = _normalize(pattern)
+	end
+	return pattern, plain
 end
 
 
@@ -55,12 +65,18 @@ local function receive(field, inner, currentValue, newValue)
 end
 
 
-local function remove(field, inner, currentValue, pattern, plain)
-	if match(field, nil, currentValue, pattern, plain) then
+local function remove(field, inner, currentValue, plainPatterns, wildcardPatterns)
+	if currentValue == nil or plainPatterns[currentValue] then
 		return nil, _EMPTY
-	else
-		return currentValue, _EMPTY
 	end
+
+	for i = 1, #wildcardPatterns do
+		if match(field, nil, currentValue, wildcardPatterns[i], false) then
+			return nil, _EMPTY
+		end
+	end
+
+	return currentValue, _EMPTY
 end
 
 
@@ -68,6 +84,7 @@ Field.registerKind('file', {
 	default = default,
 	match = match,
 	merge = merge,
+	new = new,
 	pattern = pattern,
 	receive = receive,
 	remove = remove
@@ -26,11 +26,16 @@ end
 
 
 local function merge(field, inner, currentValues, incomingValues, plain)
-	currentValues = currentValues or {}
+	currentValues = currentValues or table.new(#incomingValues, #incomingValues)
 	return set.appendArrays(currentValues, incomingValues)
 end
 
 
+local function new(field, inner, size)
+	return table.new(size, size)
+end
+
+
 local function pattern(field, inner, pattern)
 	return inner(field, pattern)
 end
@@ -52,21 +57,34 @@ local function receive(field, inner, currentValues, incomingValues, plain)
 end
 
 
-local function remove(field, inner, currentValues, pattern, plain)
+local function remove(field, inner, currentValues, plainPatterns, wildcardPatterns)
 	currentValues = currentValues or {}
-	local removedValues = {}
+	local removedValues = _EMPTY
 
-	local i = 1
-	while i <= #currentValues do
+	-- Slide the values being kept down over the ones being removed, in a single pass
+	local n = #currentValues
+	local kept = 0
+	for i = 1, n do
 		local value = currentValues[i]
-		if inner(field, value, pattern, plain) == nil then
-			table.insert(removedValues, value)
-			set.removeAt(currentValues, i)
+		if inner(field, value, plainPatterns, wildcardPatterns) == nil then
+			if removedValues == _EMPTY then
+				removedValues = {}
+			end
+			removedValues[#removedValues + 1] = value
 		else
-			i = i + 1
+			kept = kept + 1
+			currentValues[kept] = value
 		end
 	end
 
+	for i = kept + 1, n do
+		currentValues[i] = nil
+	end
+
+	for i = 1, #removedValues do
+		currentValues[removedValues[i]] = nil
+	end
+
 	return currentValues, removedValues
 end
 
@@ -75,6 +93,7 @@ Field.registerKind('set', {
 	default = default,
 	match = match,
 	merge = merge,
+	new = new,
 	pattern = pattern,
 	receive = receive,
 	remove = remove
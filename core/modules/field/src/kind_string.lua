@@ -21,6 +21,11 @@ local function merge(field, inner, currentValue, newValue)
 end
 
 
+local function new()
+	return nil
+end
+
+
 local function pattern(field, inner, pattern)
 	return string.expandWildcards(pattern)
 end
@@ -31,12 +36,18 @@ local function receive(field, inner, currentValue, newValue)
 end
 
 
-local function remove(field, inner, currentValue, pattern, plain)
-	if match(field, nil, currentValue, pattern, plain) then
+local function remove(field, inner, currentValue, plainPatterns, wildcardPatterns)
+	if currentValue == nil or plainPatterns[currentValue] then
 		return nil, _EMPTY
-	else
-		return currentValue, _EMPTY
 	end
+
+	for i = 1, #wildcardPatterns do
+		if match(field, nil, currentValue, wildcardPatterns[i], false) then
+			return nil, _EMPTY
+		end
+	end
+
+	return currentValue, _EMPTY
 end
 
 
@@ -44,6 +55,7 @@ Field.registerKind('string', {
 	default = default,
 	match = match,
 	merge = merge,
+	new = new,
 	pattern = pattern,
 	receive = receive,
 	remove = remove
@@ -71,3 +71,19 @@ function FieldRegisterTests.remove_removesField_onValidField()
 	Field.remove(testField)
 	test.isFalse(Field.exists('testField'))
 end
+
+
+---
+-- Each registered field should be given a unique integer id.
+---
+
+function FieldRegisterTests.register_assignsUniqueId()
+	local otherField = Field.register({
+		name = 'otherTestField',
+		kind = 'string'
+	})
+	Field.remove(otherField)
+
+	test.isEqual('number', type(testField.id))
+	test.isFalse(testField.id == otherField.id)
+end
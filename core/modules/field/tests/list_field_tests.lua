@@ -26,6 +26,11 @@ function ListFieldTests.default_isEmptyList()
 end
 
 
+function ListFieldTests.newValue_isEmptyList()
+	test.isEqual({}, testField:newValue(8))
+end
+
+
 ---
 -- Match...
 ---
@@ -102,6 +107,18 @@ function ListFieldTests.removeValues_removes_onMultipleMatchingValue()
 	test.isEqual({ 'u', 'x', 'z' }, value)
 end
 
+function ListFieldTests.removeValues_removesEachDuplicate_inOrder()
+	local value, removedValues = testField:removeValues({ 'x', 'y', 'x', 'z', 'x' }, { 'x' })
+	test.isEqual({ 'y', 'z' }, value)
+	test.isEqual({ 'x', 'x', 'x' }, removedValues)
+end
+
+function ListFieldTests.removeValues_returnsRemoved_inPatternOrder()
+	local value, removedValues = testField:removeValues({ 'w', 'x', 'y', 'z', 'x' }, { 'z', { 'x' }, 'w' })
+	test.isEqual({ 'y' }, value)
+	test.isEqual({ 'z', 'x', 'x', 'w' }, removedValues)
+end
+
 function ListFieldTests.removeValues_doesNothing_onMismatch()
 	local value = testField:removeValues({ 'x', 'y', 'z' }, { 'a' })
 	test.isEqual({ 'x', 'y', 'z' }, value)
@@ -105,8 +105,14 @@ function SetFieldTests.removeValues_removes_onMultipleMatchingValue()
 	test.isEqual({ 'v', 'w', 'y' }, removedValues)
 end
 
+function SetFieldTests.removeValues_allowsValueToBeAddedAgain()
+	local value = testField:removeValues(set.of('x', 'y', 'z'), { 'y' })
+	value = testField:mergeValues(value, { 'y' })
+	test.isEqual(set.of('x', 'z', 'y'), value)
+end
+
 function SetFieldTests.removeValues_doesNothing_onMismatch()
-	local value = testField:removeValues(set.of('x', 'y', 'z'), { 'a' })
+	local value, removedValues = testField:removeValues(set.of('x', 'y', 'z'), { 'a' })
 	test.isEqual(set.of('x', 'y', 'z'), value)
 	test.isEqual({}, removedValues)
 end
@@ -26,6 +26,11 @@ function StringFieldTests.default_isNil()
 end
 
 
+function StringFieldTests.newValue_isNil()
+	test.isNil(testField:newValue(8))
+end
+
+
 ---
 -- Match should pass exact values and fail mismatches.
 ---
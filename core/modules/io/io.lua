@@ -4,6 +4,8 @@
 
 local path = require('path')
 
+local _io_open = io.open
+
 
 ---
 -- Replacement `io.open()` which creates any missing subdirectories if the
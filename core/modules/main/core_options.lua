@@ -5,6 +5,11 @@
 local m = select(1, ...)
 
 
+commandLineOption {
+	trigger = '--cache',
+	description = 'Reuse the results of the project scripts from the last run with the same inputs'
+}
+
 commandLineOption {
 	trigger = '--file',
 	description = string.format('Read FILE as a Premake script; default is "%s"', m.PROJECT_SCRIPT_NAME),
@@ -12,6 +17,11 @@ commandLineOption {
 	default = m.PROJECT_SCRIPT_NAME
 }
 
+commandLineOption {
+	trigger = '--force',
+	description = 'Regenerate all files, even if their inputs have not changed'
+}
+
 commandLineOption { -- TODO: Move to help module; use `register()`
 	trigger = '--help',
 	description = 'Display this information',
@@ -21,6 +31,11 @@ commandLineOption { -- TODO: Move to help module; use `register()`
 	end
 }
 
+commandLineOption {
+	trigger = '--query-stats',
+	description = 'Print statistics on the most expensive configuration queries'
+}
+
 commandLineOption {
 	trigger = '--scripts',
 	description = "Search for additional scripts on the given path",
@@ -5,9 +5,12 @@
 -- the program entry point and overall execution flow.
 ---
 
+local cache = require('cache')
 local options = require('options')
 local path = require('path')
 local premake = require('premake')
+local State = require('state')
+local Store = require('store')
 
 
 local m = {}
@@ -49,7 +52,25 @@ end
 
 
 function m.runProjectScript()
-	doFileOpt(_PREMAKE.MAIN_SCRIPT)
+	local store = premake.store()
+
+	local function run()
+		doFileOpt(_PREMAKE.MAIN_SCRIPT)
+		Store.compact(store)
+	end
+
+	-- The cache can't see everything a script might depend on, such as environment
+	-- variables or files it checks for, so it is only used when asked for. Only cache the
+	-- results of a script which exists; there is nothing to skip otherwise.
+	if not options.isSet('--cache') or not os.isFile(_PREMAKE.MAIN_SCRIPT) then
+		run()
+		return
+	end
+
+	local cachePath = path.join(_PREMAKE.MAIN_SCRIPT_DIR, cache.FILENAME)
+	if not cache.load(cachePath, store) then
+		cache.record(cachePath, store, run)
+	end
 end
 
 
@@ -61,6 +82,13 @@ function m.validateCommandLineOptions()
 end
 
 
+function m.enableQueryStats()
+	if options.isSet('--query-stats') then
+		State.enableQueryStats()
+	end
+end
+
+
 function m.executeCommandLineOptions()
 	if #_ARGS > 0 then
 		for trigger, value in options.each() do
@@ -73,6 +101,11 @@ function m.executeCommandLineOptions()
 end
 
 
+function m.printQueryStats()
+	State.printQueryStats()
+end
+
+
 ---
 -- Main program entry point
 ---
@@ -82,7 +115,9 @@ m.steps = {
 	m.locateProjectScript,
 	m.runProjectScript,
 	m.validateCommandLineOptions,
-	m.executeCommandLineOptions
+	m.enableQueryStats,
+	m.executeCommandLineOptions,
+	m.printQueryStats
 }
 
 function m.run()
@@ -0,0 +1,246 @@
+---
+-- The export manifest records a fingerprint of the inputs used to generate each
+-- exported file, so that exporters can skip work when nothing has changed since
+-- the last run.
+--
+-- A fingerprint combines the contents of every script loaded during the run (user
+-- scripts, modules, and exporters alike), the command line arguments, the store
+-- blocks which could apply to the object being exported, and any extra values the
+-- exporter supplies, such as its own version. Glob patterns are expanded as the
+-- scripts run, so their results are captured by the store blocks.
+--
+-- Alongside the fingerprint, the manifest keeps a hash of each file produced by the
+-- export, so that files which were edited or deleted by hand are still regenerated.
+---
+
+local Condition = require('condition')
+local Field = require('field')
+local options = require('options')
+local premake = require('premake')
+local Store = require('store')
+
+local manifest = {}
+
+manifest.FILENAME = '.premake6.manifest'
+
+local _path
+local _entries
+local _isDirty = false
+
+local _scriptsHash
+local _blockHashes = setmetatable({}, { __mode = 'k' })
+
+
+---
+-- Load the manifest from a file and begin tracking exports against it. If the file
+-- does not exist, or `--force` was specified on the command line, the manifest
+-- starts out empty.
+---
+
+function manifest.open(manifestPath)
+	_path = manifestPath
+	_entries = {}
+	_isDirty = false
+
+	if options.isSet('--force') then
+		return
+	end
+
+	-- Read directly rather than via `loadFile()`, which would add the manifest to the
+	-- list of loaded scripts, and so to the fingerprints
+	local file = io.open(manifestPath, 'rb')
+	if file ~= nil then
+		local chunk = load(file:read('a'), '=manifest', 't', {})
+		file:close()
+		if chunk ~= nil then
+			local ok, entries = pcall(chunk)
+			if ok and type(entries) == 'table' then
+				_entries = entries
+			end
+		end
+	end
+end
+
+
+---
+-- Write out any changes made since the manifest was opened, and stop tracking.
+---
+
+function manifest.close()
+	if _path ~= nil and _isDirty then
+		local keys = table.sortedKeys(_entries)
+
+		local lines = { 'return {' }
+		for i = 1, #keys do
+			local key = keys[i]
+			local entry = _entries[key]
+
+			local outputs = table.sortedKeys(entry.outputs)
+
+			table.insert(lines, string.format('\t[%q] = {', key))
+			table.insert(lines, string.format('\t\tfingerprint = %d,', entry.fingerprint))
+			table.insert(lines, '\t\toutputs = {')
+			for j = 1, #outputs do
+				table.insert(lines, string.format('\t\t\t[%q] = %d,', outputs[j], entry.outputs[outputs[j]]))
+			end
+			table.insert(lines, '\t\t}')
+			table.insert(lines, '\t},')
+		end
+		table.insert(lines, '}')
+
+		io.writeFile(_path, table.concat(lines, '\n'))
+	end
+
+	_path = nil
+	_entries = nil
+	_isDirty = false
+end
+
+
+---
+-- Returns true if a manifest is currently open.
+---
+
+function manifest.isOpen()
+	return (_path ~= nil)
+end
+
+
+local function _scriptsFingerprint()
+	if _scriptsHash == nil then
+		local scripts = table.sortedKeys(_PREMAKE.LOADED_SCRIPTS)
+
+		local hashes = {}
+		for i = 1, #scripts do
+			hashes[i] = { scripts[i], io.hashFile(scripts[i]) or 0 }
+		end
+
+		_scriptsHash = table.hash(hashes)
+	end
+	return _scriptsHash
+end
+
+
+local function _blockFingerprint(block)
+	local hash = _blockHashes[block]
+	if hash == nil then
+		-- Field objects contain functions, which don't hash the same from one run to the
+		-- next; key the data by field name instead
+		local data = {}
+		for field, value in pairs(block.data) do
+			data[field.name] = value
+		end
+
+		hash = table.hash({ block.operation, Condition.hash(block.condition), data })
+		_blockHashes[block] = hash
+	end
+	return hash
+end
+
+
+---
+-- Compute a fingerprint of the inputs to an export.
+--
+-- @param scope
+--    Field-value pairs identifying the object being exported, e.g.
+--    `{ workspaces = 'MyWorkspace', projects = 'MyProject' }`. Store blocks with
+--    conditions which can not match these values are left out of the fingerprint,
+--    so editing one project doesn't invalidate the others.
+-- @param ...
+--    Any additional values which affect the output, such as an exporter version.
+-- @returns
+--    The fingerprint, as an integer, or `nil` if no manifest is open.
+---
+
+function manifest.fingerprint(scope, ...)
+	if _entries == nil then
+		return nil
+	end
+
+	local values = {}
+	for fieldName, value in pairs(scope) do
+		values[Field.get(fieldName)] = { value }
+	end
+
+	local blocks = Store.blocks(premake.store())
+	local blockHashes = {}
+	for i = 1, #blocks do
+		local block = blocks[i]
+		if Condition.canMatch(block.condition, values) then
+			table.insert(blockHashes, _blockFingerprint(block))
+		end
+	end
+
+	return table.hash({
+		_PREMAKE.VERSION,
+		premake.outputArgs(),
+		premake.env(),
+		_scriptsFingerprint(),
+		blockHashes,
+		{ ... }
+	})
+end
+
+
+---
+-- Checks whether the outputs recorded for `key` were generated from the same inputs,
+-- and are still as they were left on disk.
+--
+-- @param key
+--    Identifies the export; usually the path of its main output file.
+-- @param fingerprint
+--    The fingerprint of the export's current inputs, from `manifest.fingerprint()`.
+-- @returns
+--    True if the export can be skipped.
+---
+
+function manifest.isCurrent(key, fingerprint)
+	local entry = _entries and _entries[key]
+	if entry == nil or entry.fingerprint ~= fingerprint then
+		return false
+	end
+
+	for outputPath, hash in pairs(entry.outputs) do
+		if io.hashFile(outputPath) ~= hash then
+			return false
+		end
+	end
+
+	return true
+end
+
+
+---
+-- Record the fingerprint and outputs of an export which has just been run.
+--
+-- @param key
+--    Identifies the export; usually the path of its main output file.
+-- @param fingerprint
+--    The fingerprint of the inputs used by the export.
+-- @param outputs
+--    The list of files which may have been written (or confirmed up to date) by the
+--    export. Files which don't exist are left out.
+---
+
+function manifest.record(key, fingerprint, outputs)
+	if _entries == nil or fingerprint == nil then
+		return
+	end
+
+	local hashes = {}
+	for i = 1, #outputs do
+		hashes[outputs[i]] = io.hashFile(outputs[i])
+	end
+
+	local entry = _entries[key]
+	if entry == nil or entry.fingerprint ~= fingerprint or table.hash(entry.outputs) ~= table.hash(hashes) then
+		_entries[key] = {
+			fingerprint = fingerprint,
+			outputs = hashes
+		}
+		_isDirty = true
+	end
+end
+
+
+return manifest
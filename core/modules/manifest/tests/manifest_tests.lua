@@ -0,0 +1,110 @@
+local manifest = require('manifest')
+
+local ManifestTests = test.declare('ManifestTests', 'manifest')
+
+local _manifestPath
+local _outputPath
+
+
+function ManifestTests.setup()
+	_manifestPath = os.tmpname()
+	_outputPath = os.tmpname()
+	os.remove(_manifestPath)
+	io.writeFile(_outputPath, 'output')
+	manifest.open(_manifestPath)
+end
+
+
+function ManifestTests.teardown()
+	manifest.close()
+	os.remove(_manifestPath)
+	os.remove(_outputPath)
+end
+
+
+local function _declareProjects()
+	workspace('MyWorkspace', function ()
+		project('MyProject', function ()
+			defines 'MY_PROJECT'
+		end)
+		project('OtherProject', function ()
+			defines 'OTHER_PROJECT'
+		end)
+	end)
+end
+
+
+local function _fingerprint(projectName)
+	return manifest.fingerprint({ workspaces = 'MyWorkspace', projects = projectName }, 'test')
+end
+
+
+function ManifestTests.fingerprint_isNil_onNoOpenManifest()
+	manifest.close()
+	test.isNil(_fingerprint('MyProject'))
+end
+
+
+function ManifestTests.fingerprint_isStable_onSameInputs()
+	_declareProjects()
+	test.isEqual(_fingerprint('MyProject'), _fingerprint('MyProject'))
+end
+
+
+function ManifestTests.fingerprint_changes_onExtraValues()
+	_declareProjects()
+	local fingerprint = _fingerprint('MyProject')
+	test.isFalse(fingerprint == manifest.fingerprint({ workspaces = 'MyWorkspace', projects = 'MyProject' }, 'other'))
+end
+
+
+function ManifestTests.fingerprint_changes_onProjectSettings()
+	_declareProjects()
+	local fingerprint = _fingerprint('MyProject')
+	when({ projects = 'MyProject' }, function ()
+		defines 'CHANGED'
+	end)
+	test.isFalse(fingerprint == _fingerprint('MyProject'))
+end
+
+
+function ManifestTests.fingerprint_ignoresOtherProjects()
+	_declareProjects()
+	local fingerprint = _fingerprint('MyProject')
+	when({ projects = 'OtherProject' }, function ()
+		defines 'CHANGED'
+	end)
+	test.isEqual(fingerprint, _fingerprint('MyProject'))
+end
+
+
+function ManifestTests.isCurrent_isFalse_onUnknownKey()
+	test.isFalse(manifest.isCurrent('MyProject', 1))
+end
+
+
+function ManifestTests.isCurrent_isTrue_onRecordedFingerprint()
+	manifest.record('MyProject', 1, { _outputPath })
+	test.isTrue(manifest.isCurrent('MyProject', 1))
+end
+
+
+function ManifestTests.isCurrent_isFalse_onChangedFingerprint()
+	manifest.record('MyProject', 1, { _outputPath })
+	test.isFalse(manifest.isCurrent('MyProject', 2))
+end
+
+
+function ManifestTests.isCurrent_isFalse_onModifiedOutput()
+	manifest.record('MyProject', 1, { _outputPath })
+	io.writeFile(_outputPath, 'edited by hand')
+	test.isFalse(manifest.isCurrent('MyProject', 1))
+end
+
+
+function ManifestTests.close_savesEntries()
+	manifest.record('MyProject', 1, { _outputPath })
+	manifest.close()
+	manifest.open(_manifestPath)
+	test.isTrue(manifest.isCurrent('MyProject', 1))
+end
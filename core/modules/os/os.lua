@@ -4,10 +4,20 @@
 
 local path = require('path')
 
+local _onMatchCallbacks = {}
+
+
+local function _notifyMatch(mask, type, result)
+	for i = 1, #_onMatchCallbacks do
+		_onMatchCallbacks[i](mask, type, result)
+	end
+end
+
 
 function os.matchDirs(mask)
 	local result = {}
 	os._match(result, mask, 'dir')
+	_notifyMatch(mask, 'dir', result)
 	return result
 end
 
@@ -15,10 +25,21 @@ end
 function os.matchFiles(mask)
 	local result = {}
 	os._match(result, mask, 'file')
+	_notifyMatch(mask, 'file', result)
 	return result
 end
 
 
+---
+-- Register a function to be called with the mask, the type of match ('file' or 'dir'),
+-- and the results of each call to `os.matchFiles()` or `os.matchDirs()`.
+---
+
+function os.onMatch(fn)
+	table.insert(_onMatchCallbacks, fn)
+end
+
+
 function os._match(results, mask, type)
 	mask = path.normalize(mask)
 
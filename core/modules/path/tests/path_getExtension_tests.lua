@@ -0,0 +1,28 @@
+local path = require('path')
+
+local PathExtensionTests = test.declare('PathExtensionTests', 'path')
+
+
+function PathExtensionTests.getExtension_onDirAndExtension()
+	test.isEqual('.ext', path.getExtension('folder/filename.ext'))
+end
+
+
+function PathExtensionTests.getExtension_onNameWithExtension()
+	test.isEqual('.ext', path.getExtension('filename.ext'))
+end
+
+
+function PathExtensionTests.getExtension_onNameOnly()
+	test.isEqual('', path.getExtension('filename'))
+end
+
+
+function PathExtensionTests.getExtension_onMultipleDots()
+	test.isEqual('.gz', path.getExtension('filename.tar.gz'))
+end
+
+
+function PathExtensionTests.getExtension_ignoresDotsInDirectory()
+	test.isEqual('', path.getExtension('folder.ext/filename'))
+end
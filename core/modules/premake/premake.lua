@@ -3,6 +3,7 @@
 ---
 
 local export = require('export')
+local path = require('path')
 local State = require('state')
 local Store = require('store')
 
@@ -25,6 +26,12 @@ local _env = {}
 local _store = Store.new()
 local _testStateSnapshot
 
+-- Element list function -> the array of functions it resolved to during this run
+local _elementChains = setmetatable({}, { __mode = 'k' })
+
+-- Element list functions marked by `fixedElements()`; their chains may be cached
+local _fixedElements = setmetatable({}, { __mode = 'k' })
+
 
 ---
 -- Before running a unit test, snapshot the current baseline configuration, and restore
@@ -37,6 +44,7 @@ onRequire('testing', function (testing)
 	testing.onBeforeTest(function ()
 		snapshot = _store:snapshot()
 		_store:rollback(_testStateSnapshot)
+		premake.resetElements()
 	end)
 
 	testing.onAfterTest(function ()
@@ -57,6 +65,63 @@ function premake.callArray(funcs, ...)
 end
 
 
+---
+-- Call each function in an element list, like `callArray()`. Lists marked with
+-- `fixedElements()` are only resolved once per exporter run; the resulting array of
+-- functions is reused by every later call until `resetElements()` is called. Any other
+-- list is resolved on every call, so it may pick different elements for each object.
+--
+-- Chains are cached by the identity of the list function, so overriding an element
+-- list, e.g. by assigning a new function to `vcxproj.elements.link`, takes effect on
+-- the very next call.
+--
+-- @param list
+--    A function returning the list of functions to be called.
+-- @param ...
+--    Arguments to be passed to the list function and to each element.
+---
+
+function premake.callElements(list, ...)
+	local chain = _elementChains[list]
+	if chain == nil then
+		chain = list(...) or _EMPTY
+		if _fixedElements[list] then
+			_elementChains[list] = chain
+		end
+	end
+	for i = 1, #chain do
+		chain[i](...)
+	end
+end
+
+
+---
+-- Mark an element list as returning the same functions for every object it is called
+-- with, allowing `callElements()` to resolve it once and reuse the result.
+--
+-- @param list
+--    The element list function.
+-- @returns
+--    The same list function, to allow marking lists where they are defined.
+---
+
+function premake.fixedElements(list)
+	_fixedElements[list] = true
+	return list
+end
+
+
+---
+-- Discard the element chains resolved by `callElements()`, so that each list is built
+-- again on its next call. Exporters call this at the start of each run, which picks up
+-- any element functions which were overridden since the last one.
+---
+
+function premake.resetElements()
+	_elementChains = setmetatable({}, { __mode = 'k' })
+end
+
+
 function premake.checkRequired(obj, ...)
 	local n = select('#', ...)
 	for i = 1, n do
@@ -74,6 +139,30 @@ function premake.env()
 end
 
 
+---
+-- Return the command line arguments which can affect the exported files. Arguments which
+-- only control how the run is carried out, such as `--force`, are left out, so anything
+-- keyed on the arguments matches between runs which differ only in those.
+---
+
+local _RUN_ARGS = {
+	['--cache'] = true,
+	['--force'] = true,
+	['--query-stats'] = true,
+	['--verbose'] = true
+}
+
+function premake.outputArgs()
+	local args = {}
+	for i = 1, #_ARGS do
+		if not _RUN_ARGS[_ARGS[i]] then
+			table.insert(args, _ARGS[i])
+		end
+	end
+	return args
+end
+
+
 local _eol
 
 function premake.eol(newValue)
@@ -97,16 +186,14 @@ end
 ---
 
 function premake.export(obj, exportPath, exporter)
-	local contents = export.capture(function ()
+	local ok, err = os.mkdir(path.getDirectory(exportPath))
+	if not ok then
+		error(err, 0)
+	end
+
+	return export.stream(exportPath, function ()
 		exporter(obj)
 	end)
-
-	if not io.compareFile(exportPath, contents) then
-		io.writeFile(exportPath, contents)
-		return true
-	else
-		return false
-	end
 end
 
 
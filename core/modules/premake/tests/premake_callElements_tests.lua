@@ -0,0 +1,123 @@
+local premake = require('premake')
+
+local PremakeCallElementsTests = test.declare('PremakeCallElementsTests', 'premake')
+
+
+local _calls
+local _listBuilds
+
+local function _one(value)
+	table.insert(_calls, 'one:' .. value)
+end
+
+local function _two(value)
+	table.insert(_calls, 'two:' .. value)
+end
+
+local _list = premake.fixedElements(function ()
+	_listBuilds = _listBuilds + 1
+	return { _one, _two }
+end)
+
+
+function PremakeCallElementsTests.setup()
+	_calls = {}
+	_listBuilds = 0
+end
+
+
+---
+-- Each element should be called, in order, with the arguments.
+---
+
+function PremakeCallElementsTests.callsEachElement_withArguments()
+	premake.callElements(_list, 'x')
+	test.isEqual({ 'one:x', 'two:x' }, _calls)
+end
+
+
+---
+-- The list should only be built once, no matter how many times it is called.
+---
+
+function PremakeCallElementsTests.buildsListOnce_onRepeatedCalls()
+	premake.callElements(_list, 'x')
+	premake.callElements(_list, 'y')
+	test.isEqual(1, _listBuilds)
+	test.isEqual({ 'one:x', 'two:x', 'one:y', 'two:y' }, _calls)
+end
+
+
+---
+-- Lists which haven't been marked as fixed should be built on every call.
+---
+
+function PremakeCallElementsTests.buildsListEachCall_onUnmarkedList()
+	local list = function ()
+		_listBuilds = _listBuilds + 1
+		return { _one }
+	end
+	premake.callElements(list, 'x')
+	premake.callElements(list, 'y')
+	test.isEqual(2, _listBuilds)
+end
+
+
+---
+-- An unmarked list may pick different elements for each object it is called with,
+-- such as an override which branches on a configuration's settings.
+---
+
+function PremakeCallElementsTests.usesPerObjectElements_onUnmarkedList()
+	local list = function (kind)
+		if kind == 'StaticLibrary' then
+			return { _two }
+		end
+		return { _one }
+	end
+	premake.callElements(list, 'ConsoleApplication')
+	premake.callElements(list, 'StaticLibrary')
+	test.isEqual({ 'one:ConsoleApplication', 'two:StaticLibrary' }, _calls)
+end
+
+
+---
+-- Overriding a list replaces the list function, which must be resolved anew.
+---
+
+function PremakeCallElementsTests.usesNewList_onOverride()
+	local elements = { section = _list }
+	premake.callElements(elements.section, 'x')
+
+	local base = elements.section
+	elements.section = function ()
+		local list = base()
+		table.insert(list, 1, _two)
+		return list
+	end
+
+	premake.callElements(elements.section, 'y')
+	test.isEqual({ 'one:x', 'two:x', 'two:y', 'one:y', 'two:y' }, _calls)
+end
+
+
+---
+-- Resetting should cause lists to be rebuilt, picking up overridden elements.
+---
+
+function PremakeCallElementsTests.rebuildsList_onReset()
+	premake.callElements(_list, 'x')
+	premake.resetElements()
+	premake.callElements(_list, 'y')
+	test.isEqual(2, _listBuilds)
+end
+
+
+---
+-- A list function which returns nothing should be treated as empty.
+---
+
+function PremakeCallElementsTests.callsNothing_onNilList()
+	premake.callElements(function () end, 'x')
+	test.isEqual({}, _calls)
+end
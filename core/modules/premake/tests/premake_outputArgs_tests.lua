@@ -0,0 +1,25 @@
+local premake = require('premake')
+
+local PremakeOutputArgsTests = test.declare('PremakeOutputArgsTests', 'premake')
+
+
+local _args
+
+function PremakeOutputArgsTests.setup()
+	_args = _ARGS
+end
+
+
+function PremakeOutputArgsTests.teardown()
+	_ARGS = _args
+end
+
+
+---
+-- Arguments which only control how the run is carried out should be left out.
+---
+
+function PremakeOutputArgsTests.skipsRunArgs()
+	_ARGS = { '--force', '--file=build.lua', '--cache', 'vstudio' }
+	test.isEqual({ '--file=build.lua', 'vstudio' }, premake.outputArgs())
+end
@@ -45,6 +45,7 @@ end
 ---
 
 function set.appendArrays(self, ...)
+	local count = #self
 	local n = select('#', ...)
 	for i = 1, n do
 		local array = select(i, ...)
@@ -52,7 +53,8 @@ function set.appendArrays(self, ...)
 			local value = array[j]
 			if not self[value] then
 				self[value] = value
-				table.insert(self, value)
+				count = count + 1
+				self[count] = value
 			end
 		end
 	end
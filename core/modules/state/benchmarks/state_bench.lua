@@ -0,0 +1,73 @@
+---
+-- Measure queries against a store holding many projects, where most blocks are
+-- aimed at some other project than the one being queried.
+---
+
+local premake = require('premake')
+local State = require('state')
+
+local StateBench = bench.declare('StateBench')
+
+local _PROJECT_COUNT = 200
+
+local _snapshot
+local _workspace
+
+
+function StateBench.setup()
+	_snapshot = premake.store():snapshot()
+
+	-- `when()` rather than `workspace()` and `project()`, which need a script directory
+	when({ workspaces = 'Workspace1' }, function ()
+		configurations { 'Debug', 'Release' }
+		defines 'WKS'
+
+		for i = 1, _PROJECT_COUNT do
+			when({ projects = 'Project' .. i }, function ()
+				defines { 'PRJ' .. i }
+				when({ 'configurations:Debug' }, function ()
+					defines { 'PRJ' .. i .. '_DEBUG' }
+				end)
+			end)
+		end
+	end)
+
+	_workspace = State.new(premake.store()):select({ workspaces = 'Workspace1' })
+end
+
+
+function StateBench.teardown()
+	premake.store():rollback(_snapshot)
+end
+
+
+function StateBench.selectProject_fetch()
+	local prj = _workspace:select({ projects = 'Project100' })
+	return prj.defines
+end
+
+
+function StateBench.selectProjectConfig_fetch()
+	local cfg = _workspace:select({ projects = 'Project100' }):select({ configurations = 'Debug' })
+	return cfg.defines
+end
+
+
+function StateBench.selectProject_fetchSeveral()
+	local prj = _workspace:select({ projects = 'Project100' })
+	return prj.defines, prj.kind, prj.configurations, prj.includeDirs
+end
+
+
+function StateBench.selectProject_fetchAll()
+	local prj = _workspace:select({ projects = 'Project100' })
+	prj:fetchAll({ 'defines', 'kind', 'configurations', 'includeDirs' })
+	return prj.defines, prj.kind, prj.configurations, prj.includeDirs
+end
+
+
+function StateBench.selectProjectConfigAny_fetch()
+	State.clearQueryCache()
+	local cfg = _workspace:select({ projects = 'Project100' }):selectAny({ configurations = 'Debug', platforms = 'x86_64' })
+	return cfg.defines
+end
@@ -0,0 +1,55 @@
+---
+-- Measure queries where blocks near the top of the store test values which are only
+-- set near the bottom, so they can't be decided until late in the query.
+---
+
+local premake = require('premake')
+local State = require('state')
+
+local StateCascadeBench = bench.declare('StateCascadeBench')
+
+local _PROJECT_COUNT = 200
+
+local _snapshot
+local _workspace
+
+
+function StateCascadeBench.setup()
+	_snapshot = premake.store():snapshot()
+
+	when({ workspaces = 'Workspace1' }, function ()
+		when({ 'kind:StaticLib' }, function ()
+			defines 'STATIC'
+			rtti 'Off'
+		end)
+
+		when({ 'rtti:Off' }, function ()
+			defines 'NO_RTTI'
+		end)
+
+		when({ 'system:Windows' }, function ()
+			kind 'StaticLib'
+		end)
+
+		for i = 1, _PROJECT_COUNT do
+			when({ projects = 'Project' .. i }, function ()
+				defines { 'PRJ' .. i }
+			end)
+		end
+
+		system 'Windows'
+	end)
+
+	_workspace = State.new(premake.store()):select({ workspaces = 'Workspace1' })
+end
+
+
+function StateCascadeBench.teardown()
+	premake.store():rollback(_snapshot)
+end
+
+
+function StateCascadeBench.selectProject_fetch()
+	local prj = _workspace:select({ projects = 'Project100' })
+	return prj.defines
+end
@@ -0,0 +1,77 @@
+---
+-- Measure evaluating every configuration of a project, from a cold query cache, where
+-- most of the project's settings don't depend on the configuration.
+---
+
+local premake = require('premake')
+local State = require('state')
+
+local StateSeedBench = bench.declare('StateSeedBench')
+
+local _PROJECT_COUNT = 200
+local _SETTING_COUNT = 50
+local _CONFIGURATIONS = { 'Debug', 'Release', 'Profile', 'Final' }
+
+local _snapshot
+local _workspace
+local _project
+local _counter = 0
+
+
+function StateSeedBench.setup()
+	_snapshot = premake.store():snapshot()
+
+	when({ workspaces = 'Workspace1' }, function ()
+		configurations(_CONFIGURATIONS)
+		defines 'WKS'
+
+		for i = 1, _SETTING_COUNT do
+			when({ 'kind:StaticLib', 'system:Windows' }, function ()
+				defines { 'WKS' .. i }
+			end)
+		end
+
+		for i = 1, _PROJECT_COUNT do
+			when({ projects = 'Project' .. i }, function ()
+				kind 'StaticLib'
+				defines { 'PRJ' .. i }
+				for j = 1, _SETTING_COUNT do
+					when({ 'system:Windows' }, function ()
+						includeDirs { 'include' .. j }
+					end)
+				end
+				for j = 1, #_CONFIGURATIONS do
+					when({ configurations = _CONFIGURATIONS[j] }, function ()
+						defines { 'PRJ' .. i .. '_' .. _CONFIGURATIONS[j] }
+					end)
+				end
+			end)
+		end
+	end)
+
+	_workspace = State.new(premake.store(), { system = 'Windows' }):select({ workspaces = 'Workspace1' })
+	_project = _workspace:select({ projects = 'Project100' })
+end
+
+
+function StateSeedBench.teardown()
+	premake.store():rollback(_snapshot)
+end
+
+
+function StateSeedBench.selectConfigs_fetch()
+	State.clearQueryCache()
+	local prj = _workspace:select({ projects = 'Project100' })
+	local result = prj.defines
+	for i = 1, #_CONFIGURATIONS do
+		result = prj:select({ configurations = _CONFIGURATIONS[i] }).defines
+	end
+	return result
+end
+
+
+-- A new configuration name each time, so the configuration's query is never cached
+function StateSeedBench.selectConfig_fetch()
+	_counter = _counter + 1
+	return _project:select({ configurations = 'Config' .. _counter }).defines
+end
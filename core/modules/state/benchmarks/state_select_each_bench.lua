@@ -0,0 +1,68 @@
+---
+-- Measure fetching file-level settings for every file in a project, where only a few
+-- files have any settings of their own.
+---
+
+local premake = require('premake')
+local State = require('state')
+
+local StateSelectEachBench = bench.declare('StateSelectEachBench')
+
+local _FILE_COUNT = 500
+local _FILES_WITH_SETTINGS = 5
+
+local _snapshot
+local _files
+local _project
+
+
+function StateSelectEachBench.setup()
+	_snapshot = premake.store():snapshot()
+
+	_files = {}
+	for i = 1, _FILE_COUNT do
+		table.insert(_files, 'src/file' .. i .. '.cpp')
+	end
+
+	when({ workspaces = 'Workspace1' }, function ()
+		when({ projects = 'Project1' }, function ()
+			files(_files)
+			defines 'PRJ'
+			for i = 1, _FILES_WITH_SETTINGS do
+				when({ files = _files[i] }, function ()
+					defines { 'FILE' .. i }
+				end)
+			end
+		end)
+	end)
+
+	_project = State.new(premake.store())
+		:select({ workspaces = 'Workspace1' })
+		:select({ projects = 'Project1' })
+end
+
+
+function StateSelectEachBench.teardown()
+	premake.store():rollback(_snapshot)
+end
+
+
+function StateSelectEachBench.select_eachFile()
+	State.clearQueryCache()
+	local result
+	for i = 1, #_files do
+		result = _project:select({ files = _files[i] }).defines
+	end
+	return result
+end
+
+
+function StateSelectEachBench.selectEach_allFiles()
+	State.clearQueryCache()
+	local states, shared = _project:selectEach('files', _files)
+	local result = shared.defines
+	for _, state in pairs(states) do
+		result = state.defines
+	end
+	return result
+end
@@ -15,21 +15,55 @@ local UNKNOWN = 'UNKNOWN'
 -- Enabling the debug statements is a big performance hit.
 -- local function _debug(...) if _LOG_PREMAKE_QUERIES then print(...) end end
 
+-- While enabled, a list of statistics for each query evaluated; see `Query.enableStats()`
+local _stats = nil
+
+-- Recently evaluated query results, shared by states with the same inputs. Maps a hash
+-- of the inputs to an entry in a doubly linked list, most recently used first.
+local _CACHE_SIZE = 256
+local _cache = {}
+local _cacheCount = 0
+local _cacheHead = nil
+local _cacheTail = nil
+
 
 ---
 -- Aggregate values from a block into an existing value collection. Each time a new
 -- block gets enabled (its condition is tested and passed), this gets called to
 -- merge its contents into the accumulated value snaphot.
+--
+-- Only fields used to satisfy block conditions are aggregated. For blocks from the
+-- store, the store provides the list of those fields; blocks synthesized during the
+-- query pass `nil` and are filtered against `allFieldsTested` instead. If `changedFields`
+-- is provided, each aggregated field is appended to it.
 ---
 
-local function _accumulateValuesFromBlock(allFieldsTested, values, block, operation)
-	for field, value in pairs(block.data) do
-		-- we only care about fields that are used to satisfy block conditions; ignore others
-		if allFieldsTested[field] then
-			if operation == ADD then
-				values[field] = Field.mergeValues(field, values[field], value)
-			else
-				values[field] = Field.removeValues(field, values[field], value)
+local function _accumulateValue(values, field, value, operation)
+	if operation == ADD then
+		values[field] = Field.mergeValues(field, values[field], value)
+	else
+		values[field] = Field.removeValues(field, values[field], value)
+	end
+end
+
+
+local function _accumulateValuesFromBlock(allFieldsTested, values, block, operation, testedFields, changedFields)
+	local data = block.data
+	if testedFields ~= nil then
+		for i = 1, #testedFields do
+			local field = testedFields[i]
+			_accumulateValue(values, field, data[field], operation)
+			if changedFields then
+				changedFields[#changedFields + 1] = field
+			end
+		end
+	else
+		for field, value in pairs(data) do
+			if allFieldsTested[field] then
+				_accumulateValue(values, field, value, operation)
+				if changedFields then
+					changedFields[#changedFields + 1] = field
+				end
 			end
 		end
 	end
@@ -37,6 +71,77 @@ local function _accumulateValuesFromBlock(allFieldsTested, values, block, operat
 end
 
 
+---
+-- The worklist of undecided blocks is a binary min-heap of block indices, so the
+-- earliest block in store order is always tested next.
+---
+
+local function _pushIndex(heap, index)
+	local n = #heap + 1
+	while n > 1 do
+		local parent = n // 2
+		local parentIndex = heap[parent]
+		if parentIndex <= index then
+			break
+		end
+		heap[n] = parentIndex
+		n = parent
+	end
+	heap[n] = index
+end
+
+
+local function _popSmallest(heap)
+	local smallest = heap[1]
+
+	local n = #heap
+	local last = heap[n]
+	heap[n] = nil
+	n = n - 1
+
+	if n > 0 then
+		local i = 1
+		while true do
+			local child = i * 2
+			if child > n then
+				break
+			end
+			if child < n and heap[child + 1] < heap[child] then
+				child = child + 1
+			end
+			if heap[child] >= last then
+				break
+			end
+			heap[i] = heap[child]
+			i = child
+		end
+		heap[i] = last
+	end
+
+	return smallest
+end
+
+
+---
+-- Blocks which fail to match the accumulated global values are retested each time
+-- those values change. A condition which failed at `failedStamp` will fail again if
+-- none of the fields it tests have changed since.
+---
+
+local function _isUnchangedSince(condition, changedAt, failedStamp)
+	if failedStamp == nil then
+		return false
+	end
+	for field in pairs(Condition.fieldsTested(condition)) do
+		local stamp = changedAt[field]
+		if stamp ~= nil and stamp > failedStamp then
+			return false
+		end
+	end
+	return true
+end
+
+
 ---
 -- Aggregate values for a specific field from the currently enabled blocks. Used
 -- by value removal logic.
@@ -63,13 +168,362 @@ end
 
 
 ---
--- Evaluate a state query.
+-- Describe the scopes targeted by a query for reporting, one full path for each of its
+-- local scopes, e.g. `projects=MyProject, workspaces=MyWorkspace`.
+---
+
+local function _describeScopes(state)
+	local targetScopes = state._targetScopes
+	local descriptions = {}
+
+	for i = 1, #state._localScopes do
+		local parts = {}
+		for field, values in pairs(targetScopes[i]) do
+			if type(values) == 'table' then
+				values = table.concat(values, ' ')
+			end
+			table.insert(parts, field.name .. '=' .. tostring(values))
+		end
+		table.sort(parts)
+		table.insert(descriptions, table.concat(parts, ', '))
+	end
+
+	local description = table.concat(descriptions, ' | ')
+	if description == '' then
+		description = '(global)'
+	end
+	if state._noInheritanceVersion ~= nil then
+		description = description .. ' (inherited)'
+	end
+	return description
+end
+
+
+---
+-- Hash the inputs to a query: the store contents are checked separately, against the
+-- version saved with each cache entry. Field objects are replaced by their ids, which
+-- are much cheaper to hash than the fields themselves.
+---
+
+local function _fieldIds(values)
+	local result = {}
+	for field, value in pairs(values) do
+		result[field.id] = value
+	end
+	return result
+end
+
+
+local function _scopeIds(scopes)
+	local result = {}
+	for i = 1, #scopes do
+		result[i] = _fieldIds(scopes[i])
+	end
+	return result
+end
+
+
+local function _cacheKey(state)
+	return table.hash({
+		#state._localScopes,
+		_fieldIds(state._initialValues),
+		_fieldIds(state._anyFields),
+		_scopeIds(state._targetScopes),
+		_scopeIds(state._globalScopes)
+	})
+end
+
+
+---
+-- Unlink a cache entry from the recently used list.
+---
+
+local function _cacheUnlink(entry)
+	if entry.prev ~= nil then
+		entry.prev.next = entry.next
+	else
+		_cacheHead = entry.next
+	end
+	if entry.next ~= nil then
+		entry.next.prev = entry.prev
+	else
+		_cacheTail = entry.prev
+	end
+	entry.prev = nil
+	entry.next = nil
+end
+
+
+local function _cachePushFront(entry)
+	entry.next = _cacheHead
+	if _cacheHead ~= nil then
+		_cacheHead.prev = entry
+	else
+		_cacheTail = entry
+	end
+	_cacheHead = entry
+end
+
+
+---
+-- Look up the results of an earlier query with the same inputs, against the same
+-- store contents, marking it as the most recently used.
+---
+
+local function _cacheGet(key, version)
+	local entry = _cache[key]
+	if entry == nil or entry.version ~= version then
+		return nil
+	end
+	if entry ~= _cacheHead then
+		_cacheUnlink(entry)
+		_cachePushFront(entry)
+	end
+	return entry
+end
+
+
+---
+-- Save the results of a query, evicting the least recently used entry if the cache
+-- is full.
+---
+
+local function _cachePut(key, version, enabledBlocks, enabledByIndex, record)
+	local entry = _cache[key]
+	if entry ~= nil then
+		_cacheUnlink(entry)
+	else
+		if _cacheCount == _CACHE_SIZE then
+			local oldest = _cacheTail
+			_cacheUnlink(oldest)
+			_cache[oldest.key] = nil
+		else
+			_cacheCount = _cacheCount + 1
+		end
+		entry = { key = key }
+		_cache[key] = entry
+	end
+
+	entry.version = version
+	entry.enabledBlocks = enabledBlocks
+	entry.enabledByIndex = enabledByIndex
+	entry.record = record
+	_cachePushFront(entry)
+end
+
+
+---
+-- Discard all cached query results. Queries never see stale results, since entries
+-- are checked against the store contents; this is for benchmarks and tests which
+-- need to measure the queries themselves.
+---
+
+function Query.clearCache()
+	_cache = {}
+	_cacheCount = 0
+	_cacheHead = nil
+	_cacheTail = nil
+end
+
+
+---
+-- Start collecting statistics for each query which is evaluated, discarding any which
+-- were collected before.
+---
+
+function Query.enableStats()
+	_stats = {}
+end
+
+
+function Query.disableStats()
+	_stats = nil
+end
+
+
+---
+-- Returns the statistics collected since `enableStats()` was called, or `nil` if they
+-- are not being collected. Each entry in the list describes one query:
+--
+--   scope         The scopes targeted by the query, as text
+--   blocks        The number of blocks in the store
+--   considered    Blocks which the store's scope index passed on to the query
+--   prefiltered   Of those, blocks rejected up front because they don't test the scopes
+--   evaluations   Times a block condition was tested against the accumulated values
+--   requeued      Times an undecided block was queued for retesting after values changed
+--   synthesized   ADD blocks created to stay additive around removed values
+--   seeded        Blocks not tested, as the container's results could be reused for them
+--   time          Time taken by the query, in seconds
+--   cached        True if the results were reused from an earlier, equivalent query
+---
+
+function Query.stats()
+	return _stats
+end
+
+
+---
+-- When seeding a query from its container's evaluation, find the blocks which need to be
+-- looked at again. Blocks which test one of my local scope fields, such as `configurations`,
+-- could come out differently for me than for my container; so could any block which tests
+-- a value set by one of those blocks, and so on. REMOVE blocks, which depend on the target
+-- scopes, and blocks which my container never considered are always included.
 --
 -- @returns
---    A list of state blocks which apply to the state's scopes and initial values.
+--    A set of the store indices of the blocks to be tested, and a set of the fields tested
+--    by those blocks' conditions.
 ---
 
-function Query.evaluate(state)
+local function _testsAny(condition, fields)
+	for field in pairs(Condition.fieldsTested(condition)) do
+		if fields[field] then
+			return true
+		end
+	end
+	return false
+end
+
+
+local function _findDirtyBlocks(state, sourceBlocks, sourceIndices, seed)
+	local store = state._store
+
+	local dirtyFields = {}
+	local localScopes = state._localScopes
+	for i = 1, #localScopes do
+		for field in pairs(localScopes[i]) do
+			dirtyFields[field] = true
+		end
+	end
+
+	local isDirty = {}
+	local seedIndices = seed.indices
+	local seedPos = 1
+
+	local changed = true
+	while changed do
+		changed = false
+		for i = 1, #sourceBlocks do
+			local storeIndex = sourceIndices[i]
+			if not isDirty[storeIndex] then
+				local block = sourceBlocks[i]
+
+				-- Both lists are in store order; step through the container's in parallel
+				local wasConsidered = true
+				if seedPos ~= nil then
+					while seedIndices[seedPos] ~= nil and seedIndices[seedPos] < storeIndex do
+						seedPos = seedPos + 1
+					end
+					wasConsidered = (seedIndices[seedPos] == storeIndex)
+				end
+
+				if not wasConsidered or block.operation == REMOVE or _testsAny(block.condition, dirtyFields) then
+					isDirty[storeIndex] = true
+					local fields = Store.testedFieldsOf(store, storeIndex)
+					for j = 1, #fields do
+						local field = fields[j]
+						if not dirtyFields[field] then
+							dirtyFields[field] = true
+							changed = true
+						end
+					end
+				end
+			end
+		end
+
+		-- Blocks not considered by the container were all marked on the first pass
+		seedPos = nil
+	end
+
+	local neededFields = {}
+	for i = 1, #sourceBlocks do
+		if isDirty[sourceIndices[i]] then
+			for field in pairs(Condition.fieldsTested(sourceBlocks[i].condition)) do
+				neededFields[field] = true
+			end
+		end
+	end
+
+	return isDirty, neededFields
+end
+
+
+---
+-- A query can only be seeded from its container's evaluation if blocks which don't test
+-- any of its local scope fields can't apply to its target scopes, which is true unless
+-- it also targets its container's scopes, as when inheriting.
+---
+
+local function _canSeedFromContainer(state)
+	if state._container == nil then
+		return false
+	end
+
+	local localFields = {}
+	local localScopes = state._localScopes
+	for i = 1, #localScopes do
+		for field in pairs(localScopes[i]) do
+			localFields[field] = true
+		end
+	end
+
+	local targetScopes = state._targetScopes
+	for i = 1, #targetScopes do
+		local hasLocalField = false
+		for field in pairs(targetScopes[i]) do
+			if localFields[field] then
+				hasLocalField = true
+				break
+			end
+		end
+		if not hasLocalField then
+			return false
+		end
+	end
+
+	return true
+end
+
+
+---
+-- Merge the blocks decided by a seeded query with those replayed from its container, in
+-- store order, for `_fetchFieldValue()`. `replayedIndices` lists the positions of the
+-- replayed decisions in the query's record of tested blocks.
+---
+
+local function _inStoreOrder(store, blockResults, replayedIndices, testedIndices, testedOperations)
+	local blocks = Store.blocks(store)
+
+	local result = table.move(blockResults, 1, #blockResults, 1, {})
+	for i = 1, #replayedIndices do
+		local storeIndex = testedIndices[replayedIndices[i]]
+		table.insert(result, {
+			globalOperation = testedOperations[replayedIndices[i]],
+			sourceBlock = blocks[storeIndex],
+			storeIndex = storeIndex
+		})
+	end
+
+	table.sort(result, function (a, b)
+		return a.storeIndex < b.storeIndex
+	end)
+	return result
+end
+
+
+---
+-- Evaluate a query; see `Query.evaluate()`.
+--
+-- If `seed` is provided, it is the record of the container's evaluation. The container has
+-- already tested every block its scopes could reach, in the same order I would, and for
+-- all but the "dirty" blocks (see `_findDirtyBlocks()`) its decisions are also mine. Only
+-- the dirty blocks are tested; as I work through them, the container's decisions on the
+-- other blocks are replayed at the point they were made, so values accumulate in the same
+-- order as they would in a full evaluation.
+---
+
+local function _evaluate(state, startTime, seed)
+	local stats = _stats
+
 	-- In order to properly handle removed values (see `state_remove_tests.lua`), evaluation must
 	-- accumulate two parallels states: a "target" state, or the one requested by the caller, and
 	-- a "global" state which includes all values that could possibly be inherited by the target
@@ -79,40 +533,59 @@ function Query.evaluate(state)
 	local targetValues = Field.receiveAllValues(state._initialValues)
 	local globalValues = Field.receiveAllValues(state._initialValues)
 
-	local sourceBlocks = state._sourceBlocks
 	local targetScopes = state._targetScopes
 	local globalScopes = state._globalScopes
 
+	-- Bitsets of the fields in each scope, for quick scope testing
+	local targetMasks = Condition.scopeMasks(targetScopes, state._anyFields)
+	local globalMasks = Condition.scopeMasks(globalScopes, state._anyFields)
+
+	-- Only blocks which could apply to one of my scopes need to be considered
+	local store = state._store
+	local sourceBlocks, sourceIndices = Store.blocksForScopes(store, globalScopes, targetScopes)
+
 	-- _debug('TARGET SCOPES:', table.toString(targetScopes))
 	-- _debug('GLOBAL SCOPES:', table.toString(globalScopes))
 	-- _debug('INITIAL VALUES:', table.toString(targetValues))
 
+	local isDirty, neededFields
+	if seed ~= nil then
+		isDirty, neededFields = _findDirtyBlocks(state, sourceBlocks, sourceIndices, seed)
+	end
+
 	-- The list of incoming source blocks is shared and shouldn't be modified. Set up a parallel
 	-- list to keep track of which blocks we've tested, and the per-block test results.
 
 	local blockResults = {}
 
 	for i = 1, #sourceBlocks do
-		table.insert(blockResults, {
-			targetOperation = UNKNOWN,
-			globalOperation = UNKNOWN,
-			sourceBlock = sourceBlocks[i]
-		})
+		local storeIndex = sourceIndices[i]
+		if isDirty == nil or isDirty[storeIndex] then
+			table.insert(blockResults, {
+				targetOperation = UNKNOWN,
+				globalOperation = UNKNOWN,
+				sourceBlock = sourceBlocks[i],
+				storeIndex = storeIndex
+			})
+		end
 	end
 
 	-- Optimization: blocks that don't match any of our scopes can be eliminated right up
 	-- front. I don't have enough in place to performance test this yet. Probably a small
 	-- hit for projects and workspaces, good win for file-level configuration.
 
-	for i = 1, #sourceBlocks do
+	local prefiltered = 0
+
+	for i = 1, #blockResults do
 		local blockResult = blockResults[i]
 		local sourceBlock = blockResult.sourceBlock
 		if sourceBlock.operation == ADD then
 			local condition = sourceBlock.condition
-			if not Condition.doesTestScopeValues(condition, globalScopes) then
+			if not Condition.doesTestScopeValues(condition, globalScopes, globalMasks) then
 				blockResult.globalOperation = OUT_OF_SCOPE
+				prefiltered = prefiltered + 1
 			end
-			if not Condition.doesTestScopeValues(condition, targetScopes) then
+			if not Condition.doesTestScopeValues(condition, targetScopes, targetMasks) then
 				blockResult.targetOperation = OUT_OF_SCOPE
 			end
 		end
@@ -121,172 +594,382 @@ function Query.evaluate(state)
 	-- Optimization: only fields actually mentioned by block conditions are aggregated
 	local allFieldsTested = Condition.allFieldsTested()
 
-	-- Set up to iterate the list of blocks multiple times. Each time new values are
-	-- added or removed from the target state, any blocks that had been previously skipped
-	-- over need to be rechecked to see if they have come into scope as a result.
+	-- Undecided blocks are tested from a worklist, always taking the earliest block in store
+	-- order first. When a block is accepted and changes the accumulated global values, only
+	-- the blocks whose conditions test one of the changed fields go back on the list, which
+	-- gives the same results, in the same order, as rescanning every undecided block.
+	local worklist = {}
+	local queued = {}
+	for i = 1, #blockResults do
+		if blockResults[i].globalOperation == UNKNOWN then
+			-- pushing in order keeps the heap property without any sifting
+			table.insert(worklist, i)
+			queued[i] = true
+		end
+	end
 
-	local i = 1
+	-- Field -> list of the blocks which failed a test involving that field
+	local waitingOn = {}
+
+	-- Remember when each condition last failed, and when each global value last changed,
+	-- so unchanged conditions aren't retested. Conditions are interned, so blocks which
+	-- share a condition share the result.
+	local failedAt = { [ADD] = {}, [REMOVE] = {} }
+	local changedAt = {}
+	local changedFields = {}
+	local stamp = 0
+
+	local evaluations = 0
+	local requeued = 0
+	local synthesized = 0
+
+	-- The order in which blocks were tested, and the global operation decided by each test, if
+	-- any; this is the record used to seed the queries of my contained states
+	local testedIndices = {}
+	local testedOperations = {}
+	local testedCount = 0
+
+	-- When seeded, the container's tests of the blocks which aren't dirty are replayed in turn
+	local seedIndices = seed and seed.tested or _EMPTY
+	local seedOperations = seed and seed.operations
+	local seedPos = 1
+	local replayedIndices = {}
+
+	-- Accumulated state changed; recheck the blocks which were waiting on those fields
+	local function _requeueWaiting()
+		for j = 1, #changedFields do
+			local field = changedFields[j]
+			changedFields[j] = nil
+			changedAt[field] = stamp
+
+			local waiting = waitingOn[field]
+			if waiting ~= nil then
+				for k = 1, #waiting do
+					local waitingIndex = waiting[k]
+					if not queued[waitingIndex] and blockResults[waitingIndex].globalOperation == UNKNOWN then
+						queued[waitingIndex] = true
+						_pushIndex(worklist, waitingIndex)
+						requeued = requeued + 1
+					end
+				end
+			end
+		end
+	end
 
-	while i <= #blockResults do
-		local blockResult = blockResults[i]
-		local sourceBlock = blockResult.sourceBlock
+	local function _replayNext()
+		local storeIndex = seedIndices[seedPos]
+		local operation = seedOperations[seedPos]
+		seedPos = seedPos + 1
 
-		local targetOperation = blockResult.targetOperation
-		local globalOperation = blockResult.globalOperation
+		if isDirty[storeIndex] then
+			return
+		end
 
-		if globalOperation ~= UNKNOWN then
+		testedCount = testedCount + 1
+		testedIndices[testedCount] = storeIndex
+		testedOperations[testedCount] = operation
 
-			-- We've already made a decision on this block, can skip over it now
-			i = i + 1
+		if operation then
+			replayedIndices[#replayedIndices + 1] = testedCount
 
-		else
-			local blockCondition = sourceBlock.condition
-			local blockOperation = sourceBlock.operation
-
-			-- _debug('----------------------------------------------------')
-			-- _debug('BLOCK #:', i)
-			-- _debug('BLOCK OPER:', blockOperation)
-			-- _debug('BLOCK EXPR:', table.toString(blockCondition))
-			-- _debug('TARGET VALUES:', table.toString(targetValues))
-			-- _debug('GLOBAL VALUES:', table.toString(globalValues))
-
-			local function _testBlock(sourceBlock, blockCondition, blockOperation, globalScopes, globalValues, targetScopes, targetValues)
-				if blockOperation == ADD then
-					if not Condition.matchesScopeAndValues(blockCondition, globalValues, globalScopes) then
-						return UNKNOWN, UNKNOWN
-					end
+			-- Only the values tested by the dirty blocks matter here
+			local fields = Store.testedFieldsOf(store, storeIndex)
+			for j = 1, #fields do
+				local field = fields[j]
+				if neededFields[field] then
+					_accumulateValue(globalValues, field, Store.blocks(store)[storeIndex].data[field], operation)
+					changedFields[#changedFields + 1] = field
+				end
+			end
 
-					if not Condition.matchesScopeAndValues(blockCondition, targetValues, targetScopes) then
-						return ADD, UNKNOWN
-					end
+			if #changedFields > 0 then
+				stamp = stamp + 1
+				_requeueWaiting()
+			end
+		end
+	end
 
-					return ADD, ADD
+	local function _testBlock(blockCondition, blockOperation, globalValues, targetValues)
+		if blockOperation == ADD then
+			if not Condition.matchesScopeAndValues(blockCondition, globalValues, globalScopes, nil, globalMasks) then
+				return UNKNOWN, UNKNOWN
+			end
 
-				elseif blockOperation == REMOVE then
+			if not Condition.matchesScopeAndValues(blockCondition, targetValues, targetScopes, nil, targetMasks) then
+				return ADD, UNKNOWN
+			end
 
-					-- Try to eliminate this block by comparing it to the current accumulated global state. Here
-					-- I don't care about strict scoping, and I don't care if some of the values being tested by
-					-- the block condition are missing (`NIL_MATCHES_ANY`). I'm only concerned if a value contained
-					-- in my global set of values *conflicts* with something being requested by the scope.
-					--
-					--   'configurations:Debug' == 'Debug' is a match
-					--   'configurations:Debug' == nil is a match
-					--   'configurations:Debug' == 'Release' is a fail
-					--
-					-- If the match *fails*, that means that this block will never apply to this particular scope
-					-- hierarchy, so I can reject it outright.
+			return ADD, ADD
 
-					if not Condition.matchesValues(blockCondition, globalValues, globalValues, Condition.NIL_MATCHES_ANY) then
-						return UNKNOWN, UNKNOWN
-					end
+		elseif blockOperation == REMOVE then
 
-					-- If this block matches any scope in my hierarchy then this remove applies to me
-					local i = Condition.matchesScopeAndValues(blockCondition, targetValues, targetScopes, Condition.NIL_MATCHES_ANY)
-					if i then
-						if i <= #state._localScopes then
-							-- exact scope match
-							return REMOVE, REMOVE
-						else
-							-- inherited scope match
-							return REMOVE, OUT_OF_SCOPE
-						end
-					end
+			-- Try to eliminate this block by comparing it to the current accumulated global state. Here
+			-- I don't care about strict scoping, and I don't care if some of the values being tested by
+			-- the block condition are missing (`NIL_MATCHES_ANY`). I'm only concerned if a value contained
+			-- in my global set of values *conflicts* with something being requested by the scope.
+			--
+			--   'configurations:Debug' == 'Debug' is a match
+			--   'configurations:Debug' == nil is a match
+			--   'configurations:Debug' == 'Release' is a fail
+			--
+			-- If the match *fails*, that means that this block will never apply to this particular scope
+			-- hierarchy, so I can reject it outright.
 
-					-- Okay, doesn't apply to me, but does it apply to one of my parent containers (something "above" me), or
-					-- a sibling container (something "next to" or "below" me). If the block matches something in my global
-					-- scope then I can assumed that it will be handled before I even see it.
-					if Condition.matchesScopeAndValues(blockCondition, globalValues, globalScopes) then
-						return OUT_OF_SCOPE, REMOVE
-					end
+			if not Condition.matchesValues(blockCondition, globalValues, globalValues, Condition.NIL_MATCHES_ANY) then
+				return UNKNOWN, UNKNOWN
+			end
 
-					-- So...this block passed the "soft" match against the global values, but failed against my
-					-- specific scoping. That means it is intended for a sibling of the target scope: a different
-					-- project, configuration, etc. from the one that is currently being built. In order to keep
-					-- things additive, that means I find myself in the uncomfortable position of having to *add*
-					-- the value in, rather than remove...see notes in test suite and (eventually) the README.
-					return REMOVE, ADD
+			-- If this block matches any scope in my hierarchy then this remove applies to me
+			local i = Condition.matchesScopeAndValues(blockCondition, targetValues, targetScopes, Condition.NIL_MATCHES_ANY, targetMasks)
+			if i then
+				if i <= #state._localScopes then
+					-- exact scope match
+					return REMOVE, REMOVE
+				else
+					-- inherited scope match
+					return REMOVE, OUT_OF_SCOPE
 				end
 			end
 
-			globalOperation, targetOperation = _testBlock(sourceBlock, blockCondition, blockOperation, globalScopes, globalValues, targetScopes, targetValues)
-			-- _debug('GLOBAL RESULT:', globalOperation)
-			-- _debug('TARGET RESULT:', targetOperation)
-
-			if targetOperation == ADD and globalOperation == REMOVE then
-				-- I've hit the sibling of a scope which removed values. To stay additive, the values were actually
-				-- removed by my container. Now I'm in the awkward position of needing to add them back in. Can't be
-				-- just a simple add though: have to make sure I only add in values that might have actually been set.
-				-- Might have to deal with wildcard matches. Need to synthesize a new ADD block for this. Start by
-				-- excluding the current remove block from the target results.
-				blockResult.targetOperation = OUT_OF_SCOPE
+			-- Okay, doesn't apply to me, but does it apply to one of my parent containers (something "above" me), or
+			-- a sibling container (something "next to" or "below" me). If the block matches something in my global
+			-- scope then I can assumed that it will be handled before I even see it.
+			if Condition.matchesScopeAndValues(blockCondition, globalValues, globalScopes, nil, globalMasks) then
+				return OUT_OF_SCOPE, REMOVE
+			end
 
-				-- Then build a new block and insert values that would be removed by the container
-				local newAddBlock = Block.new(Block.ADD, _EMPTY)
+			-- So...this block passed the "soft" match against the global values, but failed against my
+			-- specific scoping. That means it is intended for a sibling of the target scope: a different
+			-- project, configuration, etc. from the one that is currently being built. In order to keep
+			-- things additive, that means I find myself in the uncomfortable position of having to *add*
+			-- the value in, rather than remove...see notes in test suite and (eventually) the README.
+			return REMOVE, ADD
+		end
+	end
 
-				for field, removePatterns in pairs(sourceBlock.data) do
-					local currentGlobalValues = _fetchFieldValue(field, blockResults)
-					local currentTargetValues = targetValues[field] or _EMPTY
+	local function _testNext()
+		local i = _popSmallest(worklist)
+		queued[i] = nil
 
-					-- Run the block's remove patterns against the accumulated global state. Check to see if any of
-					-- the removed values are *not* present in the current target state. Those are the values that now
-					-- need to be added back in to the target state. I iterate and add them individually because in
-					-- this case we don't want to add duplicates even if the field would otherwise allow it.
-					local removedValues
-					currentGlobalValues[field], removedValues = Field.removeValues(field, currentGlobalValues, removePatterns)
+		local blockResult = blockResults[i]
+		local sourceBlock = blockResult.sourceBlock
 
-					for i = 1, #removedValues do
-						local value = removedValues[i]
-						if not Field.matches(field, currentTargetValues, value) then
-							Block.receive(newAddBlock, field, value)
-						end
-					end
+		local blockCondition = sourceBlock.condition
+		local blockOperation = sourceBlock.operation
 
-				end
+		-- _debug('----------------------------------------------------')
+		-- _debug('BLOCK #:', i)
+		-- _debug('BLOCK OPER:', blockOperation)
+		-- _debug('BLOCK EXPR:', table.toString(blockCondition))
+		-- _debug('TARGET VALUES:', table.toString(targetValues))
+		-- _debug('GLOBAL VALUES:', table.toString(globalValues))
 
-				-- Insert the new block into my result list
+		local globalOperation, targetOperation
 
-				table.insert(blockResults, i, {
-					targetOperation = ADD,
-					globalOperation = OUT_OF_SCOPE,
-					sourceBlock = newAddBlock
-				})
+		local failures = failedAt[blockOperation]
+		if _isUnchangedSince(blockCondition, changedAt, failures[blockCondition]) then
+			globalOperation, targetOperation = UNKNOWN, UNKNOWN
+		else
+			evaluations = evaluations + 1
+			globalOperation, targetOperation = _testBlock(blockCondition, blockOperation, globalValues, targetValues)
+			if globalOperation == UNKNOWN and targetOperation == UNKNOWN then
+				failures[blockCondition] = stamp
+			end
+		end
+		-- _debug('GLOBAL RESULT:', globalOperation)
+		-- _debug('TARGET RESULT:', targetOperation)
+
+		if targetOperation == ADD and globalOperation == REMOVE then
+			-- I've hit the sibling of a scope which removed values. To stay additive, the values were actually
+			-- removed by my container. Now I'm in the awkward position of needing to add them back in. Can't be
+			-- just a simple add though: have to make sure I only add in values that might have actually been set.
+			-- Might have to deal with wildcard matches. Need to synthesize a new ADD block for this. Start by
+			-- excluding the current remove block from the target results.
+			blockResult.targetOperation = OUT_OF_SCOPE
+
+			-- Then build a new block and insert values that would be removed by the container
+			local newAddBlock = Block.new(Block.ADD, _EMPTY)
+			synthesized = synthesized + 1
+
+			local decidedResults = blockResults
+			if #replayedIndices > 0 then
+				decidedResults = _inStoreOrder(store, blockResults, replayedIndices, testedIndices, testedOperations)
+			end
 
-				targetValues = _accumulateValuesFromBlock(allFieldsTested, targetValues, newAddBlock, ADD)
+			for field, removePatterns in pairs(sourceBlock.data) do
+				local currentGlobalValues = _fetchFieldValue(field, decidedResults)
+				local currentTargetValues = targetValues[field] or _EMPTY
+
+				-- Run the block's remove patterns against the accumulated global state. Check to see if any of
+				-- the removed values are *not* present in the current target state. Those are the values that now
+				-- need to be added back in to the target state. I iterate and add them individually because in
+				-- this case we don't want to add duplicates even if the field would otherwise allow it.
+				local removedValues
+				currentGlobalValues[field], removedValues = Field.removeValues(field, currentGlobalValues, removePatterns)
+
+				for j = 1, #removedValues do
+					local value = removedValues[j]
+					if not Field.matches(field, currentTargetValues, value) then
+						Block.receive(newAddBlock, field, value)
+					end
+				end
 
-			elseif targetOperation ~= UNKNOWN then
-				blockResult.targetOperation = targetOperation
-				targetValues = _accumulateValuesFromBlock(allFieldsTested, targetValues, sourceBlock, targetOperation)
 			end
 
-			if globalOperation ~= UNKNOWN then
-				blockResult.globalOperation = globalOperation -- TODO: do I need to store this? Once values have been processed at the global scope I'm done?
-				globalValues = _accumulateValuesFromBlock(allFieldsTested, globalValues, sourceBlock, globalOperation)
-			end
+			-- Insert the new block into my result list, just ahead of the remove block
+			blockResult.synthesizedBlock = newAddBlock
 
+			targetValues = _accumulateValuesFromBlock(allFieldsTested, targetValues, newAddBlock, ADD)
 
-			-- If accumulated state changed rerun previously skipped blocks to see if they should now be enabled
-			if globalOperation ~= UNKNOWN then
-				-- _debug('STATE CHANGED, rerunning skipped blocks')
-				i = 1
-			else
-				i = i + 1
+		elseif targetOperation ~= UNKNOWN then
+			blockResult.targetOperation = targetOperation
+			targetValues = _accumulateValuesFromBlock(allFieldsTested, targetValues, sourceBlock, targetOperation, Store.testedFieldsOf(store, blockResult.storeIndex))
+		end
+
+		testedCount = testedCount + 1
+		testedIndices[testedCount] = blockResult.storeIndex
+		testedOperations[testedCount] = (globalOperation ~= UNKNOWN and globalOperation)
+
+		if globalOperation ~= UNKNOWN then
+			blockResult.globalOperation = globalOperation -- TODO: do I need to store this? Once values have been processed at the global scope I'm done?
+			stamp = stamp + 1
+			globalValues = _accumulateValuesFromBlock(allFieldsTested, globalValues, sourceBlock, globalOperation, Store.testedFieldsOf(store, blockResult.storeIndex), changedFields)
+			_requeueWaiting()
+
+		elseif not blockResult.isWaiting then
+			-- Still undecided; wait for a change to one of the fields it tests
+			blockResult.isWaiting = true
+			for field in pairs(Condition.fieldsTested(blockCondition)) do
+				local waiting = waitingOn[field]
+				if waiting == nil then
+					waiting = {}
+					waitingOn[field] = waiting
+				end
+				table.insert(waiting, i)
 			end
 		end
 	end
 
+	while true do
+		-- If the container tested another block before the next one on my worklist, that comes first
+		local nextResult = worklist[1]
+		local seedIndex = seedIndices[seedPos]
+		if seedIndex ~= nil and (nextResult == nil or seedIndex < blockResults[nextResult].storeIndex) then
+			_replayNext()
+		elseif nextResult ~= nil then
+			_testNext()
+		else
+			break
+		end
+	end
+
 	-- Create a new list of just the enabled blocks to return to the caller
 
 	local enabledBlocks = {}
+	local enabledByIndex = {}
 
 	for i = 1, #blockResults do
 		local blockResult = blockResults[i]
+
+		local synthesizedBlock = blockResult.synthesizedBlock
+		if synthesizedBlock ~= nil then
+			table.insert(enabledBlocks, Block.new(ADD, _EMPTY, synthesizedBlock.data))
+			enabledByIndex = nil
+		end
+
 		local operation = blockResult.targetOperation
 		if operation == ADD or operation == REMOVE then
-			table.insert(enabledBlocks, Block.new(operation, _EMPTY, blockResult.sourceBlock.data))
+			local block = Block.new(operation, _EMPTY, blockResult.sourceBlock.data)
+			table.insert(enabledBlocks, block)
+
+			local storeIndex = blockResult.storeIndex
+			if storeIndex == nil then
+				enabledByIndex = nil
+			elseif enabledByIndex ~= nil then
+				enabledByIndex[storeIndex] = block
+			end
 		end
 	end
 
-	return enabledBlocks
+	if stats then
+		table.insert(stats, {
+			scope = _describeScopes(state),
+			blocks = #Store.blocks(store),
+			considered = #sourceBlocks,
+			prefiltered = prefiltered,
+			evaluations = evaluations,
+			requeued = requeued,
+			synthesized = synthesized,
+			seeded = #sourceBlocks - #blockResults,
+			time = os.clock() - startTime,
+			cached = false
+		})
+	end
+
+	local record = {
+		indices = sourceIndices,
+		tested = testedIndices,
+		operations = testedOperations
+	}
+
+	return enabledBlocks, enabledByIndex, record
+end
+
+
+---
+-- Evaluate a state query.
+--
+-- Results are cached and shared between states which have the same scopes and initial
+-- values, such as the same project selected from two different workspace states. The
+-- returned lists must not be modified.
+--
+-- States selected from a container are seeded with the container's evaluation, which is
+-- done first if needed, and only the blocks which could be affected by the narrower scope
+-- are tested again.
+--
+-- @returns
+--    A list of state blocks which apply to the state's scopes and initial values;
+--    a table mapping the store index of each source block to its enabled block, or
+--    `nil` if any blocks had to be synthesized to satisfy removes; and a record of
+--    the evaluation, used to seed the queries of contained states.
+---
+
+function Query.evaluate(state)
+	local stats = _stats
+	local startTime = stats and os.clock()
+
+	local version = Store.version(state._store)
+	local key = _cacheKey(state)
+
+	local entry = _cacheGet(key, version)
+	if entry ~= nil then
+		if stats then
+			table.insert(stats, {
+				scope = _describeScopes(state),
+				blocks = #Store.blocks(state._store),
+				considered = 0,
+				prefiltered = 0,
+				evaluations = 0,
+				requeued = 0,
+				synthesized = 0,
+				seeded = 0,
+				time = os.clock() - startTime,
+				cached = true
+			})
+		end
+		return entry.enabledBlocks, entry.enabledByIndex, entry.record
+	end
+
+	local seed
+	if _canSeedFromContainer(state) then
+		local _
+		_, _, seed = Query.evaluate(state._container)
+		startTime = stats and os.clock()
+	end
+
+	local enabledBlocks, enabledByIndex, record = _evaluate(state, startTime, seed)
+	_cachePut(key, version, enabledBlocks, enabledByIndex, record)
+	return enabledBlocks, enabledByIndex, record
 end
 
 
@@ -43,26 +43,80 @@ State.__newindex = function(self, key, value)
 end
 
 
+local function _mergeBlockValue(result, block, field)
+	local blockValue = block.data[field]
+	if blockValue ~= nil then
+		if block.operation == _ADD then
+			result = Field.mergeValues(field, result, blockValue)
+		else
+			result = Field.removeValues(field, result, blockValue)
+		end
+	end
+	return result
+end
+
+
 ---
--- Iterate over a list of blocks; collect and return the values for `field`.
+-- Collect and return the values for `field` from the blocks enabled by a query.
+--
+-- If the query could map its enabled blocks back to the store, and fewer blocks in
+-- the store set this field than were enabled, only those blocks are visited.
+-- Otherwise, every enabled block is checked for the field. The blocks are visited
+-- twice: once to size the result to hold every value added to it, and again to
+-- merge the values in, so that the result never has to grow.
 ---
 
-local function _buildValue(blocks, field)
-	local result = nil
+local function _buildValue(state, field)
+	local blocks = state._blocks
+	local enabledByIndex = state._enabledByIndex
 
-	for i = 1, #blocks do
-		local block = blocks[i]
-		local blockValue = block.data[field]
+	local blockIndices
+	if enabledByIndex ~= nil then
+		blockIndices = Store.blocksWithField(state._store, field)
+		if #blockIndices >= #blocks then
+			blockIndices = nil
+		end
+	end
+
+	local count = (blockIndices ~= nil) and #blockIndices or #blocks
+
+	local isSet = false
+	local size = 0
+	for i = 1, count do
+		local block
+		if blockIndices ~= nil then
+			block = enabledByIndex[blockIndices[i]]
+		else
+			block = blocks[i]
+		end
+
+		local blockValue = block and block.data[field]
 		if blockValue ~= nil then
-			local operation = block.operation
-			if operation == _ADD then
-				result = Field.mergeValues(field, result, blockValue)
-			else
-				result = Field.removeValues(field, result, blockValue)
+			isSet = true
+			if block.operation == _ADD and type(blockValue) == 'table' then
+				size = size + #blockValue
 			end
 		end
 	end
 
+	if not isSet then
+		return nil
+	end
+
+	local result = Field.newValue(field, size)
+	for i = 1, count do
+		local block
+		if blockIndices ~= nil then
+			block = enabledByIndex[blockIndices[i]]
+		else
+			block = blocks[i]
+		end
+
+		if block ~= nil then
+			result = _mergeBlockValue(result, block, field)
+		end
+	end
+
 	return result
 end
 
@@ -80,6 +134,8 @@ local function _new(state)
 		[State] = table.mergeKeys({
 			_container = nil,
 			_blocks = _EMPTY,
+			_enabledByIndex = nil,
+			_anyFields = _EMPTY,
 			_unsetValues = {}
 		}, state)
 	})
@@ -100,7 +156,7 @@ end
 
 function State.new(store, initialState)
 	return _new({
-		_sourceBlocks = Store.blocks(store),
+		_store = store,
 		_initialValues = Field.receiveAllValues(initialState),
 
 		_localScopes = _EMPTY_SCOPE,
@@ -112,6 +168,17 @@ function State.new(store, initialState)
 end
 
 
+---
+-- On the first fetch, filter the store's list of blocks to only those that apply to us.
+---
+
+local function _evaluateIfNeeded(state)
+	if state._blocks == _EMPTY then
+		state._blocks, state._enabledByIndex = Query.evaluate(state)
+	end
+end
+
+
 ---
 -- Retrieve a value from a state.
 --
@@ -143,10 +210,7 @@ function State.fetch(self, fieldName)
 		return nil
 	end
 
-	-- If this is the first fetch, filter the store's list of blocks to only those that apply to us
-	if state._blocks == _EMPTY then
-		state._blocks = Query.evaluate(state)
-	end
+	_evaluateIfNeeded(state)
 
 	-- If this is a request for one of the scope values which was used to seed this query, return
 	-- that exact value without collecting any additional values from the query results. Otherwise,
@@ -157,7 +221,7 @@ function State.fetch(self, fieldName)
 		if field.isScope and initialValues[field] ~= nil then
 			value = initialValues[field]
 		else
-			value = _buildValue(state._blocks, field) or initialValues[field] or Field.defaultValue(field)
+			value = _buildValue(state, field) or initialValues[field] or Field.defaultValue(field)
 		end
 	end
 
@@ -173,6 +237,167 @@ function State.fetch(self, fieldName)
 end
 
 
+---
+-- Retrieve many values from a state at once, ex. all of the fields an exporter is about to
+-- read from a configuration. Rather than walking the enabled blocks once for each field,
+-- as `fetch()` would, all of the fields are collected in a single pass. The values go into
+-- the same cache used by dot-indexing, where they can then be read as usual.
+--
+-- @param fieldNames
+--    The list of field names to retrieve. Fields which have already been fetched are skipped.
+---
+
+function State.fetchAll(self, fieldNames)
+	local state = self[State]
+	_evaluateIfNeeded(state)
+
+	local initialValues = state._initialValues
+	local unsetValues = state._unsetValues
+	local store = state._store
+
+	-- Field -> name, for each field which still has to be built from the enabled blocks
+	local pending = {}
+	local indexedCount = 0
+
+	for i = 1, #fieldNames do
+		local fieldName = fieldNames[i]
+		if rawget(self, fieldName) == nil and unsetValues[fieldName] == nil then
+			local field = Field.tryGet(fieldName)
+			if field == nil then
+				unsetValues[fieldName] = true
+			elseif field.isScope and initialValues[field] ~= nil then
+				self[fieldName] = initialValues[field]
+			else
+				pending[field] = fieldName
+				indexedCount = indexedCount + #Store.blocksWithField(store, field)
+			end
+		end
+	end
+
+	local results = {}
+
+	-- If the store's per-field block lists are shorter between them than the list of enabled
+	-- blocks, following those is still cheaper than the single pass
+	local blocks = state._blocks
+	if state._enabledByIndex ~= nil and indexedCount < #blocks then
+		for field in pairs(pending) do
+			results[field] = _buildValue(state, field)
+		end
+	else
+		for i = 1, #blocks do
+			local block = blocks[i]
+			for field in pairs(block.data) do
+				if pending[field] ~= nil then
+					results[field] = _mergeBlockValue(results[field], block, field)
+				end
+			end
+		end
+	end
+
+	for field, fieldName in pairs(pending) do
+		local value = results[field] or initialValues[field] or Field.defaultValue(field)
+		if value == nil then
+			unsetValues[fieldName] = true
+		else
+			self[fieldName] = value
+		end
+	end
+end
+
+
+---
+-- Discard the query results shared between equivalent states. This is never needed for
+-- correctness; results are only reused while the store contents are unchanged.
+---
+
+function State.clearQueryCache()
+	Query.clearCache()
+end
+
+
+---
+-- Start collecting statistics on each query, to help track down expensive ones. See
+-- `printQueryStats()`.
+---
+
+function State.enableQueryStats()
+	Query.enableStats()
+end
+
+
+function State.disableQueryStats()
+	Query.disableStats()
+end
+
+
+---
+-- Returns the list of per-query statistics collected since `enableQueryStats()` was
+-- called, or `nil` if statistics aren't being collected.
+---
+
+function State.queryStats()
+	return Query.stats()
+end
+
+
+---
+-- Print the collected query statistics, totaled by scope, most time consuming first.
+--
+-- @param limit
+--    The maximum number of scopes to list; defaults to 20.
+---
+
+function State.printQueryStats(limit)
+	local stats = Query.stats()
+	if stats == nil then
+		return
+	end
+
+	local totals = {}
+	local scopes = {}
+	local totalTime = 0
+
+	for i = 1, #stats do
+		local entry = stats[i]
+		local total = totals[entry.scope]
+		if total == nil then
+			total = { scope = entry.scope, queries = 0, cached = 0, considered = 0, prefiltered = 0, evaluations = 0, requeued = 0, synthesized = 0, seeded = 0, time = 0 }
+			totals[entry.scope] = total
+			table.insert(scopes, total)
+		end
+		total.queries = total.queries + 1
+		if entry.cached then
+			total.cached = total.cached + 1
+		end
+		total.considered = total.considered + entry.considered
+		total.prefiltered = total.prefiltered + entry.prefiltered
+		total.evaluations = total.evaluations + entry.evaluations
+		total.requeued = total.requeued + entry.requeued
+		total.synthesized = total.synthesized + entry.synthesized
+		total.seeded = total.seeded + entry.seeded
+		total.time = total.time + entry.time
+		totalTime = totalTime + entry.time
+	end
+
+	table.sort(scopes, function (a, b)
+		if a.time ~= b.time then
+			return a.time > b.time
+		end
+		return a.scope < b.scope
+	end)
+
+	limit = math.min(limit or 20, #scopes)
+
+	printf('%d queries over %d scopes took %.1f ms; top %d by time:', #stats, #scopes, totalTime * 1000, limit)
+	printf('%10s %8s %7s %11s %7s %12s %12s %9s %12s  %s', 'time (ms)', 'queries', 'cached', 'considered', 'seeded', 'prefiltered', 'evaluations', 'requeued', 'synthesized', 'scope')
+	for i = 1, limit do
+		local total = scopes[i]
+		printf('%10.2f %8d %7d %11d %7d %12d %12d %9d %12d  %s', total.time * 1000, total.queries, total.cached, total.considered, total.seeded,
+			total.prefiltered, total.evaluations, total.requeued, total.synthesized, total.scope)
+	end
+end
+
+
 ---
 -- Selects a contained or child state out of an existing container state, ex. a project
 -- from a workspace.
@@ -185,7 +410,7 @@ end
 --    A new State instance representing the target contained scope.
 ---
 
-function _select(self, localScopes)
+function _select(self, localScopes, anyFields)
 	local container = self[State]
 
 	-- make sure we're using the "clean" instance so we don't get values from parent
@@ -193,6 +418,13 @@ function _select(self, localScopes)
 		container = container._noInheritanceVersion[State]
 	end
 
+	-- "Any of" fields carry down to contained states, ex. the files in a configuration
+	if anyFields ~= nil then
+		anyFields = table.mergeKeys(container._anyFields, anyFields)
+	else
+		anyFields = container._anyFields
+	end
+
 	local initialValues = container._initialValues
 	for i = 1, #localScopes do
 		localScopes[i] = Field.receiveAllValues(localScopes[i])
@@ -221,13 +453,14 @@ function _select(self, localScopes)
 	end
 
 	return _new({
-		_sourceBlocks = container._sourceBlocks,
+		_store = container._store,
 		_initialValues = initialValues,
 		_container = self[State],
 
 		_localScopes = localScopes,
 		_targetScopes = targetScopes,
 		_globalScopes = globalScopes,
+		_anyFields = anyFields,
 
 		_includes = includes
 	})
@@ -243,6 +476,12 @@ end
 -- Selects a contained or child state out of an existing container state, ex. a project
 -- from a workspace.
 --
+-- Rather than one scope for every combination of keys, the keys are kept together in a
+-- single scope, and marked as "any of" fields: a block condition is in scope if it tests
+-- at least one of them, along with everything required by the container. Each condition's
+-- tested fields are checked against the keys once, so the cost of the query is the same
+-- however many keys are provided. Conditions are tested against all of the keys' values.
+--
 -- @param scope
 --    A table of key-value pairs describing the target state, ex. `{ projects='Project1' }`.
 --    If multiple keys are provided they are assumed to be OR-ed together; use `select()`
@@ -252,25 +491,78 @@ end
 ---
 
 function State.selectAny(self, scope)
-	-- Decompose the incoming scope into one scope per key-value, so they can each be
-	-- matched individually, i.e. so we can match any of them. Turns `{ A, B }` into
-	-- `{ {A}, {B} }`
-	local localScopes = {}
-	for key, value in pairs(scope) do
-		table.insert(localScopes, { [key] = value })
+	scope = Field.receiveAllValues(scope)
+
+	local anyFields = {}
+	for field in pairs(scope) do
+		anyFields[field] = true
 	end
 
-	-- We also need to match the case where all the scopes are provided (AND instead of OR)
-	if #localScopes > 1 then
-		table.insert(localScopes, scope)
+	return _select(self, { scope }, anyFields)
+end
+
+
+---
+-- Selects a contained state for each of a list of values of a single scope field, ex. each
+-- file in a project, as if by calling `select({ [field] = value })` for each value.
+--
+-- Usually only a few values are mentioned by any block condition; the rest have no settings
+-- of their own. A value which matches none of the clauses on `field` can't change the result
+-- of any condition, so all such values can share a single state, evaluated just once. The
+-- conditions testing `field` are collected in a single pass over the store.
+--
+-- @param fieldName
+--    The name of the scope field being selected, ex. 'files'.
+-- @param values
+--    The list of values for which states should be selected.
+-- @returns
+--    A table mapping each value which is mentioned by some condition to its own state, the
+--    state shared by all of the other values, or `nil` if every value has its own, and the
+--    value the shared state was selected with. The shared state reports that value for
+--    `fieldName`; all of its other results are the same for every value which shares it.
+---
+
+function State.selectEach(self, fieldName, values)
+	local field = Field.get(fieldName)
+
+	local conditions = {}
+	local seen = {}
+	local blocks = Store.blocks(self[State]._store)
+	for i = 1, #blocks do
+		local condition = blocks[i].condition
+		if not seen[condition] then
+			seen[condition] = true
+			if Condition.fieldsTested(condition)[field] then
+				table.insert(conditions, condition)
+			end
+		end
 	end
 
-	-- TODO: This is only handling the case where two scopes are provided, i.e. 'configurations'
-	-- and 'platforms'. If three or more or provided, this would also need to add scopes for
-	-- each possible combination. For an input of `{ A, B, C }`, the code above turns it into
-	-- `{ {A}, {B}, {A, B, C}}` but misses `{ {A,B}, {A,C}, {B,C} }`.
+	local states = {}
+	local shared
+	local sharedValue
+
+	for i = 1, #values do
+		local value = values[i]
+		local receivedValue = Field.receiveValues(field, nil, value)
+
+		local isMentioned = false
+		for j = 1, #conditions do
+			if Condition.hasClauseMatching(conditions[j], field, receivedValue) then
+				isMentioned = true
+				break
+			end
+		end
 
-	return _select(self, localScopes)
+		if isMentioned then
+			states[value] = _select(self, { { [field] = value } })
+		elseif shared == nil then
+			shared = _select(self, { { [field] = value } })
+			sharedValue = value
+		end
+	end
+
+	return states, shared, sharedValue
 end
 
 
@@ -304,10 +596,18 @@ function State.fromScopes(self, ...)
 		end
 	end
 
-	return _new(table.mergeKeys(state, {
+	local newState = table.mergeKeys(state, {
 		_targetScopes = allScopes,
 		_includes = includes
-	}))
+	})
+
+	-- Anything already evaluated by this state only covers the narrower scopes; start over
+	newState._blocks = _EMPTY
+	newState._enabledByIndex = nil
+	newState._unsetValues = {}
+	newState._withInheritanceVersion = nil
+
+	return _new(newState)
 end
 
 
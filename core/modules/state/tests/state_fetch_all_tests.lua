@@ -0,0 +1,72 @@
+---
+-- Test fetching many values from a state at once.
+---
+
+local premake = require('premake')
+local State = require('state')
+
+local StateFetchAllTests = test.declare('StateFetchAllTests', 'state')
+
+
+local _prj
+
+function StateFetchAllTests.setup()
+	workspace('Workspace1', function ()
+		project('Project1', function ()
+			kind 'StaticLib'
+			defines { 'A', 'B' }
+			includeDirs 'include'
+
+			when({ 'kind:StaticLib' }, function ()
+				defines 'LIB'
+				removeDefines 'A'
+			end)
+		end)
+	end)
+
+	_prj = State.new(premake.store(), { system = 'Windows' })
+		:select({ workspaces = 'Workspace1' })
+		:select({ projects = 'Project1' })
+end
+
+
+---
+-- Values fetched together should be the same as those fetched one at a time.
+---
+
+function StateFetchAllTests.matchesFetch()
+	local names = { 'defines', 'includeDirs', 'kind', 'system', 'rtti' }
+	_prj:fetchAll(names)
+
+	local other = State.new(premake.store(), { system = 'Windows' })
+		:select({ workspaces = 'Workspace1' })
+		:select({ projects = 'Project1' })
+
+	for i = 1, #names do
+		test.isEqual(other[names[i]], _prj[names[i]])
+	end
+end
+
+
+---
+-- Values should be placed in the same cache used by dot-indexing.
+---
+
+function StateFetchAllTests.cachesValues()
+	_prj:fetchAll({ 'defines', 'kind' })
+	test.isEqual({ 'B', 'LIB' }, rawget(_prj, 'defines'))
+	test.isEqual('StaticLib', rawget(_prj, 'kind'))
+end
+
+
+function StateFetchAllTests.skipsFetchedValues()
+	local defines = _prj.defines
+	_prj:fetchAll({ 'defines' })
+	test.isTrue(defines == _prj.defines)
+end
+
+
+function StateFetchAllTests.returnsNil_onUnknownField()
+	_prj:fetchAll({ 'notAField' })
+	test.isNil(_prj.notAField)
+end
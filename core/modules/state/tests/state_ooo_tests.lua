@@ -22,3 +22,25 @@ function StateOooTests.select_enableBlock_outOfOrder()
 	local global = State.new(premake.store())
 	test.isEqual({ 'CLI' }, global.defines)
 end
+
+
+---
+-- Blocks enabled out of order should in turn enable earlier blocks which depend on them,
+-- and values should still be accumulated in the order the blocks were defined.
+---
+
+function StateOooTests.select_enableBlocks_inChain()
+	when({ 'kind:StaticLib' }, function ()
+		defines 'STATIC'
+	end)
+
+	when({ 'system:Windows' }, function ()
+		kind 'StaticLib'
+	end)
+
+	defines 'FIRST'
+	system 'Windows'
+
+	local global = State.new(premake.store())
+	test.isEqual({ 'STATIC', 'FIRST' }, global.defines)
+end
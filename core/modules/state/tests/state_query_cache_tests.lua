@@ -0,0 +1,108 @@
+---
+-- Test sharing of query results between equivalent states.
+---
+
+local premake = require('premake')
+local State = require('state')
+
+local StateQueryCacheTests = test.declare('StateQueryCacheTests', 'state')
+
+
+local _global
+
+function StateQueryCacheTests.setup()
+	workspace('Workspace1', function ()
+		projects { 'Project1', 'Project2' }
+		defines 'WKS'
+
+		when({ 'projects:Project1' }, function ()
+			defines 'PRJ1'
+		end)
+	end)
+
+	_global = State.new(premake.store())
+	State.clearQueryCache()
+	State.enableQueryStats()
+end
+
+
+function StateQueryCacheTests.teardown()
+	State.disableQueryStats()
+end
+
+
+local function _lastStats()
+	local stats = State.queryStats()
+	return stats[#stats]
+end
+
+
+local function _selectProject(name)
+	return _global
+		:select({ workspaces = 'Workspace1' })
+		:select({ projects = name })
+end
+
+
+---
+-- Equivalent states selected from different containers should share query results.
+---
+
+function StateQueryCacheTests.reusesResults_onEquivalentState()
+	local _ = _selectProject('Project1').defines
+	local prj = _selectProject('Project1')
+	test.isEqual({ 'PRJ1' }, prj.defines)
+
+	local stats = State.queryStats()
+	test.isFalse(stats[#stats - 1].cached)
+	test.isTrue(stats[#stats].cached)
+end
+
+
+function StateQueryCacheTests.evaluates_onDifferentScope()
+	local _ = _selectProject('Project1').defines
+	local prj = _selectProject('Project2')
+	test.isEqual({}, prj.defines)
+	test.isFalse(_lastStats().cached)
+end
+
+
+function StateQueryCacheTests.evaluates_onDifferentInitialValues()
+	local _ = _selectProject('Project1').defines
+	local prj = State.new(premake.store(), { system = 'Windows' })
+		:select({ workspaces = 'Workspace1' })
+		:select({ projects = 'Project1' })
+	local _ = prj.defines
+	test.isFalse(_lastStats().cached)
+end
+
+
+---
+-- Results should not be reused once the store contents have changed.
+---
+
+function StateQueryCacheTests.evaluates_onStoreChange()
+	local _ = _selectProject('Project1').defines
+
+	when({ 'workspaces:Workspace1', 'projects:Project1' }, function ()
+		defines 'LATE'
+	end)
+
+	local prj = _selectProject('Project1')
+	test.isEqual({ 'PRJ1', 'LATE' }, prj.defines)
+	test.isFalse(_lastStats().cached)
+end
+
+
+function StateQueryCacheTests.reusesResults_afterRollback()
+	local store = premake.store()
+	local _ = _selectProject('Project1').defines
+
+	local snapshot = store:snapshot()
+	defines 'TEMPORARY'
+	store:rollback(snapshot)
+
+	local prj = _selectProject('Project1')
+	test.isEqual({ 'PRJ1' }, prj.defines)
+	test.isTrue(_lastStats().cached)
+end
@@ -447,6 +447,65 @@ function StateRemoveTests.workspaceAdds_globProjConfigRemoves_removesFromTarget(
 end
 
 
+---
+-- Values added back to siblings follow the order of the patterns which removed them.
+---
+
+function StateRemoveTests.workspaceAdds_configRemovesMany_addsToSiblings_inPatternOrder()
+	workspace('Workspace1', function ()
+		configurations { 'Debug', 'Release' }
+		defines { 'C', 'F' }
+
+		when({ 'configurations:Debug' }, function ()
+			removeDefines { 'F', 'C' }
+		end)
+	end)
+
+	local wks = _global:select({ workspaces = 'Workspace1' })
+	local cfg = wks:select({ configurations = 'Release' })
+	test.isEqual({ 'F', 'C' }, cfg.defines)
+end
+
+
+---
+-- A remove which tests two keys only applies where both match. Selecting on any of the
+-- keys tests the condition against all of their values, so a sibling which matches only
+-- one of the two keys keeps the value.
+---
+
+local function _workspaceWithTwoKeyRemove()
+	workspace('Workspace1', function ()
+		configurations { 'Debug', 'Release' }
+		platforms { 'x86', 'x64' }
+		defines { 'B', 'E' }
+
+		when({ 'configurations:Release', 'platforms:x86' }, function ()
+			removeDefines 'B'
+		end)
+	end)
+
+	return _global:select({ workspaces = 'Workspace1' }):withInheritance()
+end
+
+
+function StateRemoveTests.workspaceAdds_twoKeyRemoves_keepsValue_onSiblingMatchingOneKey()
+	local wks = _workspaceWithTwoKeyRemove()
+
+	local cfg = wks:selectAny({ configurations = 'Debug', platforms = 'x86' }):fromScopes(wks):withInheritance()
+	test.isEqual({ 'B', 'E' }, cfg.defines)
+
+	cfg = wks:selectAny({ configurations = 'Release', platforms = 'x64' }):fromScopes(wks):withInheritance()
+	test.isEqual({ 'B', 'E' }, cfg.defines)
+end
+
+
+function StateRemoveTests.workspaceAdds_twoKeyRemoves_removesValue_onBothKeysMatching()
+	local wks = _workspaceWithTwoKeyRemove()
+	local cfg = wks:selectAny({ configurations = 'Release', platforms = 'x86' }):fromScopes(wks):withInheritance()
+	test.isEqual({ 'E' }, cfg.defines)
+end
+
+
 ---
 -- When adding values back into a configuration, should only add values that would have
 -- actually been removed at the outer scopes.
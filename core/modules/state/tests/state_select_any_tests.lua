@@ -0,0 +1,120 @@
+---
+-- Test selecting on any of several scope keys at once.
+---
+
+local Field = require('field')
+local premake = require('premake')
+local State = require('state')
+
+local StateSelectAnyTests = test.declare('StateSelectAnyTests', 'state')
+
+
+local _toolsets
+local _global
+
+function StateSelectAnyTests.setup()
+	_toolsets = Field.register({
+		name = 'toolsets',
+		kind = 'string',
+		isScope = true
+	})
+
+	defines 'GLOB'
+
+	when({ 'configurations:Debug' }, function ()
+		defines 'DEBUG'
+	end)
+
+	when({ 'platforms:macOS' }, function ()
+		defines 'MAC'
+	end)
+
+	when({ toolsets = 'clang' }, function ()
+		defines 'CLANG'
+	end)
+
+	when({ 'configurations:Debug', toolsets = 'clang' }, function ()
+		defines 'DEBUG_CLANG'
+	end)
+
+	when({ 'configurations:Debug', 'platforms:macOS', toolsets = 'clang' }, function ()
+		defines 'DEBUG_MAC_CLANG'
+	end)
+
+	when({ 'configurations:Release', toolsets = 'clang' }, function ()
+		defines 'RELEASE_CLANG'
+	end)
+
+	when({ 'configurations:Debug', 'platforms:not macOS' }, function ()
+		defines 'DEBUG_NOT_MAC'
+	end)
+
+	_global = State.new(premake.store())
+end
+
+
+function StateSelectAnyTests.teardown()
+	Field.remove(_toolsets)
+end
+
+
+---
+-- With three or more keys, blocks testing any combination of the keys should be included,
+-- so long as all of the keys they test match.
+---
+
+function StateSelectAnyTests.includesEachCombination_onThreeKeys()
+	local cfg = _global:selectAny({ configurations = 'Debug', platforms = 'macOS', toolsets = 'clang' })
+	test.isEqual({ 'DEBUG', 'MAC', 'CLANG', 'DEBUG_CLANG', 'DEBUG_MAC_CLANG' }, cfg.defines)
+end
+
+
+function StateSelectAnyTests.includesGeneralSettings_onThreeKeys_withInheritance()
+	local cfg = _global:selectAny({ configurations = 'Debug', platforms = 'macOS', toolsets = 'clang' }):withInheritance()
+	test.isEqual({ 'GLOB', 'DEBUG', 'MAC', 'CLANG', 'DEBUG_CLANG', 'DEBUG_MAC_CLANG' }, cfg.defines)
+end
+
+
+---
+-- Conditions are tested against the values of all of the keys, even the ones which are
+-- negated, rather than those of a subset.
+---
+
+function StateSelectAnyTests.excludesBlock_onNegatedKey()
+	local cfg = _global:selectAny({ configurations = 'Debug', platforms = 'macOS' })
+	test.isEqual({ 'DEBUG', 'MAC' }, cfg.defines)
+end
+
+
+function StateSelectAnyTests.includesBlock_onNegatedKey_whenNotMatched()
+	local cfg = _global:selectAny({ configurations = 'Debug', platforms = 'iOS' })
+	test.isEqual({ 'DEBUG', 'DEBUG_NOT_MAC' }, cfg.defines)
+end
+
+
+---
+-- The keys should carry down to contained states.
+---
+
+function StateSelectAnyTests.carriesKeysToContainedStates()
+	when({ 'files:hello.c', 'platforms:macOS' }, function ()
+		defines 'HELLO_MAC'
+	end)
+
+	local cfg = _global:selectAny({ configurations = 'Debug', platforms = 'macOS' })
+	local file = cfg:select({ files = 'hello.c' })
+	test.isEqual({ 'HELLO_MAC' }, file.defines)
+end
+
+
+---
+-- Selecting on all of the keys is a different query than selecting on any of them, even
+-- though the scope values are the same.
+---
+
+function StateSelectAnyTests.differsFromSelect_onSameKeys()
+	local any = _global:selectAny({ configurations = 'Debug', platforms = 'macOS' })
+	local all = _global:select({ configurations = 'Debug', platforms = 'macOS' })
+	test.isEqual({ 'DEBUG', 'MAC' }, any.defines)
+	test.isEqual({}, all.defines)
+end
@@ -0,0 +1,68 @@
+---
+-- Test selecting many states at once, sharing a state between values with no settings.
+---
+
+local premake = require('premake')
+local State = require('state')
+
+local StateSelectEachTests = test.declare('StateSelectEachTests', 'state')
+
+
+local _prj
+
+function StateSelectEachTests.setup()
+	workspace('Workspace1', function ()
+		project('Project1', function ()
+			files { 'a.c', 'b.c', 'c.c', 'd.h' }
+			defines 'PRJ'
+
+			when({ 'files:a.c' }, function ()
+				defines 'A'
+			end)
+
+			when({ 'files:d.h' }, function ()
+				defines 'HEADER'
+			end)
+		end)
+	end)
+
+	_prj = State.new(premake.store())
+		:select({ workspaces = 'Workspace1' })
+		:select({ projects = 'Project1' })
+end
+
+
+---
+-- Values mentioned by a condition get a state of their own.
+---
+
+function StateSelectEachTests.selectsOwnState_onMentionedValues()
+	local states = _prj:selectEach('files', { 'a.c', 'b.c', 'c.c', 'd.h' })
+	test.isEqual({ 'A' }, states['a.c'].defines)
+	test.isEqual({ 'HEADER' }, states['d.h'].defines)
+	test.isNil(states['b.c'])
+	test.isNil(states['c.c'])
+end
+
+
+---
+-- All other values share one state, with the same results as selecting each one.
+---
+
+function StateSelectEachTests.sharesState_onUnmentionedValues()
+	local _, shared = _prj:selectEach('files', { 'a.c', 'b.c', 'c.c' })
+	test.isEqual(_prj:select({ files = 'b.c' }).files, shared.files)
+	test.isEqual(_prj:select({ files = 'c.c' }).defines, shared.defines)
+end
+
+
+function StateSelectEachTests.returnsSharedValue_onUnmentionedValues()
+	local _, _, sharedValue = _prj:selectEach('files', { 'a.c', 'b.c', 'c.c' })
+	test.isEqual('b.c', sharedValue)
+end
+
+
+function StateSelectEachTests.returnsNoSharedState_onAllMentioned()
+	local _, shared = _prj:selectEach('files', { 'a.c', 'd.h' })
+	test.isNil(shared)
+end
@@ -232,6 +232,13 @@ function StateSelectTests.select_configAndPlatform_fromWorkspaceAndGlobal()
 	test.isEqual({ 'GLOB_DEBUG_MAC', 'WKS1_DEBUG_MAC' }, cfg.defines)
 end
 
+function StateSelectTests.select_config_fromWorkspaceAndGlobal_afterFetch()
+	local wks = _global:select({ workspaces = 'Workspace1' })
+	local cfg = wks:select({ configurations = 'Debug' })
+	test.isEqual({ 'WKS1_DEBUG' }, cfg.defines)
+	test.isEqual({ 'GLOB_DEBUG', 'WKS1_DEBUG' }, cfg:fromScopes(_global).defines)
+end
+
 
 ---
 -- Continue. There is no global settings file, and the workspace can *not* store
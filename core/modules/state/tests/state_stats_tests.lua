@@ -0,0 +1,115 @@
+local premake = require('premake')
+local State = require('state')
+
+local StateStatsTests = test.declare('StateStatsTests', 'state')
+
+
+local _global
+
+function StateStatsTests.setup()
+	_global = State.new(premake.store())
+	State.clearQueryCache()
+	State.enableQueryStats()
+end
+
+
+function StateStatsTests.teardown()
+	State.disableQueryStats()
+end
+
+
+local function _declareWorkspace()
+	workspace('Workspace1', function ()
+		projects { 'Project1', 'Project2' }
+		defines { 'A', 'B' }
+
+		when({ 'projects:Project2' }, function ()
+			removeDefines 'B'
+		end)
+	end)
+end
+
+
+local function _lastStats()
+	local stats = State.queryStats()
+	return stats[#stats]
+end
+
+
+---
+-- Each query should be recorded, described by the full path of its scope. Containers are
+-- queried first, to seed the queries of the states they contain.
+---
+
+function StateStatsTests.recordsEachQuery_withScope()
+	_declareWorkspace()
+	local wks = _global:select({ workspaces = 'Workspace1' })
+	local prj = wks:select({ projects = 'Project1' })
+	local _ = prj.defines
+
+	local stats = State.queryStats()
+	test.isEqual(3, #stats)
+	test.isEqual('(global)', stats[1].scope)
+	test.isEqual('workspaces=Workspace1', stats[2].scope)
+	test.isEqual('projects=Project1, workspaces=Workspace1', stats[3].scope)
+end
+
+
+function StateStatsTests.describesGlobalScope()
+	local _ = _global.defines
+	test.isEqual('(global)', State.queryStats()[1].scope)
+end
+
+
+---
+-- Counts should reflect the work done by the query.
+---
+
+function StateStatsTests.countsBlocksAndEvaluations()
+	_declareWorkspace()
+	local wks = _global:select({ workspaces = 'Workspace1' })
+	local _ = wks:select({ projects = 'Project1' }).defines
+
+	local stats = _lastStats()
+	test.isTrue(stats.considered > 0)
+	test.isTrue(stats.evaluations > 0)
+	test.isTrue(stats.time >= 0)
+end
+
+
+function StateStatsTests.countsRequeuedBlocks_onLaterValueChange()
+	when({ 'kind:StaticLib' }, function ()
+		defines { 'STATIC' }
+	end)
+	kind 'StaticLib'
+
+	local _ = _global.defines
+	test.isEqual(1, State.queryStats()[1].requeued)
+end
+
+
+function StateStatsTests.countsSynthesizedBlocks_onSiblingRemove()
+	_declareWorkspace()
+	local wks = _global:select({ workspaces = 'Workspace1' })
+	local _ = wks:select({ projects = 'Project1' }).defines
+	test.isEqual(1, _lastStats().synthesized)
+end
+
+
+function StateStatsTests.countsSeededBlocks_onContainedState()
+	_declareWorkspace()
+	local wks = _global:select({ workspaces = 'Workspace1' })
+	local _ = wks:select({ projects = 'Project1' }).defines
+	test.isTrue(_lastStats().seeded > 0)
+end
+
+
+---
+-- Nothing should be recorded once statistics are disabled.
+---
+
+function StateStatsTests.queryStats_isNil_onDisabled()
+	State.disableQueryStats()
+	local _ = _global.defines
+	test.isNil(State.queryStats())
+end
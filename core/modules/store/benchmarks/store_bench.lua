@@ -0,0 +1,36 @@
+---
+-- Measure taking and rolling back to snapshots of a large store, as the testing module
+-- does around every test.
+---
+
+local Field = require('field')
+local Store = require('store')
+
+local StoreBench = bench.declare('StoreBench')
+
+local _BLOCK_COUNT = 10000
+
+local _DEFINES = Field.get('defines')
+
+local _store
+local _baseline
+
+
+function StoreBench.setup()
+	_store = Store.new()
+	_baseline = _store:snapshot()
+
+	for i = 1, _BLOCK_COUNT do
+		_store:pushCondition({ projects = 'Project' .. i })
+		_store:addValue(_DEFINES, 'PRJ' .. i)
+		_store:popCondition()
+	end
+end
+
+
+function StoreBench.snapshotAndRollback()
+	local snapshot = _store:snapshot()
+	_store:rollback(_baseline)
+	_store:addValue(_DEFINES, 'TEST')
+	_store:rollback(snapshot)
+end
@@ -6,12 +6,70 @@
 
 local Block = require('block')
 local Condition = require('condition')
+local Field = require('field')
 local Stack = require('stack')
 local Type = require('type')
 
 local Store = Type.declare('Store')
 
 
+---
+-- Blocks are kept in a chain of generations. New blocks are only ever appended to the
+-- newest generation, which belongs to the store; taking a snapshot freezes it and starts
+-- a new one, and rolling back starts a new generation on top of the snapshot's. Neither
+-- copies any blocks. Frozen generations hold on to their flattened block list and index
+-- once built, so returning to a snapshot picks those back up as well.
+---
+
+local function _newGeneration(parent)
+	return {
+		parent = parent,
+		blocks = {},
+		flat = nil,
+		index = nil
+	}
+end
+
+
+-- Return all of the blocks up to and including a frozen generation, as a single list
+local function _flatten(generation)
+	if generation == nil then
+		return _EMPTY
+	end
+
+	if generation.flat == nil then
+		local chain = {}
+		local base = generation
+		while base ~= nil and base.flat == nil do
+			table.insert(chain, base)
+			base = base.parent
+		end
+
+		local flat = base and table.shallowCopy(base.flat) or {}
+		for i = #chain, 1, -1 do
+			local blocks = chain[i].blocks
+			for j = 1, #blocks do
+				flat[#flat + 1] = blocks[j]
+			end
+		end
+
+		generation.flat = flat
+	end
+
+	return generation.flat
+end
+
+
+-- The most recent generation holding any blocks, which is what a snapshot must keep
+local function _lastGeneration(self)
+	local generation = self._generation
+	if #generation.blocks == 0 then
+		return generation.parent
+	end
+	return generation
+end
+
+
 ---
 -- Blocks are categorized by their operation, one of ADD or REMOVE, indicating
 -- whether they are adding values to the state (e.g. `defines('a')`) or removing
@@ -24,7 +82,15 @@ local function _getBlockFor(self, operation)
 	if block == nil or block.operation ~= operation then
 		local condition = Stack.top(self._conditions)
 		block = Block.new(operation, condition)
-		table.insert(self._blocks, block)
+		table.insert(self._generation.blocks, block)
+
+		-- Keep the flattened list up to date, unless it belongs to a frozen generation
+		if self._blocksShared then
+			self._blocks = nil
+		elseif self._blocks ~= nil then
+			table.insert(self._blocks, block)
+		end
+
 		self._currentBlock = block
 	end
 
@@ -40,21 +106,408 @@ end
 ---
 
 function Store.new()
-	-- if new fields are added here, update `snapshot()` and `restore()` too
+	-- if new fields are added here, update `snapshot()` and `rollback()` too
 	return Type.assign(Store, {
 		_conditions = Stack.new({ Condition.new(_EMPTY) }),
-		_blocks = {},
-		_currentBlock = nil
+		_generation = _newGeneration(nil),
+		_blocks = nil,
+		_blocksShared = false,
+		_currentBlock = nil,
+		_index = nil
 	})
 end
 
 
+-- The set of fields tested by any block condition in `blocks`
+local function _fieldsTested(blocks)
+	local fieldsTested = {}
+	for i = 1, #blocks do
+		for field in pairs(Condition.fieldsTested(blocks[i].condition)) do
+			fieldsTested[field] = true
+		end
+	end
+	return fieldsTested
+end
+
+
+---
+-- Index the store's blocks for querying. The index is built on demand, and discarded
+-- whenever a value is added or the store is rolled back.
+--
+-- ADD blocks are indexed by the scope values they require, e.g. `projects=Project1`, so
+-- queries can skip blocks aimed at other scopes. Each block is filed under just one of
+-- its required values, choosing the field with the most distinct values in the store,
+-- which is usually the most selective. Blocks which don't require any scope values, and
+-- all REMOVE blocks, can apply anywhere and are kept on a separate unscoped list.
+--
+-- The index also lists, for each field, the blocks which set it and, for each block,
+-- those of its fields which are tested by a block condition.
+---
+
+local function _buildIndex(self)
+	local blocks = Store.blocks(self)
+
+	local valuesSeen = {}
+	local fieldCounts = {}
+	local fieldsTested = _fieldsTested(blocks)
+
+	for i = 1, #blocks do
+		local block = blocks[i]
+
+		if block.operation == Block.ADD then
+			local required = Condition.requiredScopeValues(block.condition)
+			for j = 1, #required do
+				local field, value = required[j][1], required[j][2]
+				local seen = valuesSeen[field]
+				if seen == nil then
+					seen = {}
+					valuesSeen[field] = seen
+					fieldCounts[field] = 0
+				end
+				if not seen[value] then
+					seen[value] = true
+					fieldCounts[field] = fieldCounts[field] + 1
+				end
+			end
+		end
+	end
+
+	local byValue = {}
+	local unscoped = {}
+	local byField = {}
+	local testedData = {}
+
+	for i = 1, #blocks do
+		local block = blocks[i]
+
+		local tested = {}
+		for field in pairs(block.data) do
+			local list = byField[field]
+			if list == nil then
+				list = {}
+				byField[field] = list
+			end
+			table.insert(list, i)
+
+			if fieldsTested[field] then
+				table.insert(tested, field)
+			end
+		end
+		testedData[i] = tested
+
+		local best
+		if block.operation == Block.ADD then
+			local required = Condition.requiredScopeValues(block.condition)
+			for j = 1, #required do
+				if best == nil or fieldCounts[required[j][1]] > fieldCounts[best[1]] then
+					best = required[j]
+				end
+			end
+		end
+
+		if best == nil then
+			table.insert(unscoped, i)
+		else
+			local field, value = best[1], best[2]
+			local postings = byValue[field]
+			if postings == nil then
+				postings = {}
+				byValue[field] = postings
+			end
+			local list = postings[value]
+			if list == nil then
+				list = {}
+				postings[value] = list
+			end
+			table.insert(list, i)
+		end
+	end
+
+	return {
+		byValue = byValue,
+		unscoped = unscoped,
+		byField = byField,
+		testedData = testedData
+	}
+end
+
+
+local function _index(self)
+	local index = self._index
+	if index == nil then
+		index = _buildIndex(self)
+		self._index = index
+	end
+	return index
+end
+
+
 ---
 -- Return the list of configuration blocks contained by the store.
 ---
 
 function Store.blocks(self)
-	return self._blocks
+	local blocks = self._blocks
+
+	if blocks == nil then
+		local generation = self._generation
+		blocks = _flatten(generation.parent)
+
+		if #generation.blocks == 0 then
+			self._blocksShared = true
+		else
+			blocks = table.shallowCopy(blocks)
+			table.move(generation.blocks, 1, #generation.blocks, #blocks + 1, blocks)
+			self._blocksShared = false
+		end
+
+		self._blocks = blocks
+	end
+
+	return blocks
+end
+
+
+---
+-- Replace the contents of the store with a list of blocks, such as one loaded from the
+-- cache of a previous run.
+---
+
+function Store.setBlocks(self, blocks)
+	self._generation = _newGeneration(nil)
+	self._generation.blocks = blocks
+	self._blocks = nil
+	self._currentBlock = nil
+	self._index = nil
+	return self
+end
+
+
+---
+-- Return the blocks which could apply to any of the provided scopes, in store order.
+-- ADD blocks which require a scope value that none of the scopes provide, such as the
+-- blocks of other projects, are left out.
+--
+-- @param ...
+--    One or more lists of scopes, ex. `{ { [workspacesField] = { 'Workspace1' } } }`.
+-- @returns
+--    A list of candidate blocks, which must still be tested against the scopes, and
+--    a parallel list of their indices in the store.
+---
+
+function Store.blocksForScopes(self, ...)
+	local index = _index(self)
+
+	local byValue = index.byValue
+	local unscoped = index.unscoped
+
+	local indices = table.shallowCopy(unscoped)
+	local selected = {}
+
+	for i = 1, select('#', ...) do
+		local scopes = select(i, ...)
+		for j = 1, #scopes do
+			for field, values in pairs(scopes[j]) do
+				local postings = byValue[field]
+				if postings ~= nil then
+					if type(values) ~= 'table' then
+						values = { values }
+					end
+					for k = 1, #values do
+						local list = postings[values[k]]
+						if list ~= nil then
+							for m = 1, #list do
+								local blockIndex = list[m]
+								if not selected[blockIndex] then
+									selected[blockIndex] = true
+									table.insert(indices, blockIndex)
+								end
+							end
+						end
+					end
+				end
+			end
+		end
+	end
+
+	if #indices > #unscoped then
+		table.sort(indices)
+	end
+
+	local blocks = Store.blocks(self)
+	local result = {}
+	for i = 1, #indices do
+		result[i] = blocks[indices[i]]
+	end
+	return result, indices
+end
+
+
+---
+-- Return the indices of the blocks which set a value for `field`, in store order.
+---
+
+function Store.blocksWithField(self, field)
+	return _index(self).byField[field] or _EMPTY
+end
+
+
+---
+-- Return a value identifying the current contents of the store. It changes whenever
+-- a value is added or the blocks are replaced, and returns to its earlier value when
+-- the store is rolled back to a snapshot. The value is opaque; compare it by identity.
+---
+
+function Store.version(self)
+	return _index(self)
+end
+
+
+---
+-- Return the fields set by a block which are tested by any block's condition; these
+-- are the only values a query needs to accumulate while evaluating conditions.
+--
+-- @param blockIndex
+--    The index of the block in the store.
+---
+
+function Store.testedFieldsOf(self, blockIndex)
+	return _index(self).testedData[blockIndex]
+end
+
+
+---
+-- Compaction helpers.
+---
+
+local function _mergeData(target, data)
+	for field, value in pairs(data) do
+		target[field] = Field.mergeValues(field, target[field], value)
+	end
+	return target
+end
+
+
+local function _addKeys(target, source)
+	for key in pairs(source) do
+		target[key] = true
+	end
+end
+
+
+local function _touchesAny(data, fields)
+	for field in pairs(data) do
+		if fields[field] then
+			return true
+		end
+	end
+	return false
+end
+
+
+-- True if the block holds no values, e.g. was left by a call like `defines {}`
+local function _isEmpty(data)
+	for _, value in pairs(data) do
+		if type(value) ~= 'table' or #value > 0 or next(value) ~= nil then
+			return false
+		end
+	end
+	return true
+end
+
+
+local function _isUnconditional(block)
+	return (next(Condition.fieldsTested(block.condition)) == nil)
+end
+
+
+-- Blocks may be shared with a snapshot; copy one before merging anything into it
+local function _own(result, i, owned)
+	local block = result[i]
+	if not owned[block] then
+		block = Block.new(block.operation, block.condition, _mergeData({}, block.data))
+		owned[block] = true
+		result[i] = block
+	end
+	return block
+end
+
+
+---
+-- Reduce the number of blocks which queries need to consider, without changing their
+-- results. Meant to be called once the project scripts have finished running.
+--
+--  - Blocks which hold no values are dropped.
+--  - Adjacent ADD blocks with the same condition are merged, as long as the first
+--    doesn't set a field tested by that condition, which could change the outcome of
+--    testing the second.
+--  - Unconditional ADD blocks are hoisted back into the previous unconditional block,
+--    as long as every block in between is an ADD block which doesn't set any of the
+--    fields being moved, and no condition anywhere in the store tests them. Queries
+--    re-test earlier undecided blocks, REMOVE blocks included, whenever a field they
+--    test changes, so moving a tested field could change the outcome of a block which
+--    comes before the hoist target. This keeps the order of each field's values, and
+--    the outcome of every condition, the same.
+---
+
+function Store.compact(self)
+	local blocks = Store.blocks(self)
+	local result = {}
+	local owned = {}
+
+	-- Fields which can never be hoisted, since some condition depends on them
+	local fieldsTested = _fieldsTested(blocks)
+
+	-- Where unconditional blocks can be hoisted to, and what the blocks since have set
+	local hoistIndex
+	local fieldsSetSince
+
+	for i = 1, #blocks do
+		local block = blocks[i]
+		local operation = block.operation
+		local condition = block.condition
+
+		local n = #result
+		local previous = result[n]
+
+		if _isEmpty(block.data) then
+
+			-- nothing to keep
+
+		elseif operation == Block.ADD and previous ~= nil and previous.operation == Block.ADD and
+			previous.condition == condition and
+			not _touchesAny(previous.data, Condition.fieldsTested(condition))
+		then
+
+			_mergeData(_own(result, n, owned).data, block.data)
+			if hoistIndex ~= nil and hoistIndex ~= n then
+				_addKeys(fieldsSetSince, block.data)
+			end
+
+		elseif operation == Block.ADD and hoistIndex ~= nil and _isUnconditional(block) and
+			not _touchesAny(block.data, fieldsSetSince) and
+			not _touchesAny(block.data, fieldsTested)
+		then
+
+			_mergeData(_own(result, hoistIndex, owned).data, block.data)
+
+		else
+
+			table.insert(result, block)
+
+			if operation == Block.REMOVE then
+				hoistIndex = nil
+			elseif _isUnconditional(block) then
+				hoistIndex = n + 1
+				fieldsSetSince = {}
+			elseif hoistIndex ~= nil then
+				_addKeys(fieldsSetSince, block.data)
+			end
+
+		end
+	end
+
+	return Store.setBlocks(self, result)
 end
 
 
@@ -63,7 +516,7 @@ end
 ---
 
 function Store.debug(self)
-	print(table.toString(self._blocks))
+	print(table.toString(Store.blocks(self)))
 end
 
 
@@ -109,6 +562,7 @@ end
 function Store.addValue(self, field, value)
 	local block = _getBlockFor(self, Block.ADD)
 	Block.receive(block, field, value)
+	self._index = nil
 	return self
 end
 
@@ -120,22 +574,34 @@ end
 function Store.removeValue(self, field, value)
 	local block = _getBlockFor(self, Block.REMOVE)
 	Block.receive(block, field, value)
+	self._index = nil
 	return self
 end
 
 
 ---
--- Make a note of the current store state, so it can be rolled back later.
+-- Make a note of the current store state, so it can be rolled back later. This takes
+-- the same time no matter how many blocks the store holds.
 ---
 
 function Store.snapshot(self)
+	-- Freeze the blocks added so far, handing over the flattened list and index
+	local generation = _lastGeneration(self)
+	if generation ~= nil then
+		if generation.flat == nil and self._blocks ~= nil and not self._blocksShared then
+			generation.flat = self._blocks
+		end
+		generation.index = generation.index or self._index
+	end
+
 	local snapshot = {
 		_conditions = self._conditions,
-		_blocks = self._blocks
+		_generation = generation
 	}
 
 	self._conditions = table.shallowCopy(self._conditions)
-	self._blocks = table.shallowCopy(self._blocks)
+	self._generation = _newGeneration(generation)
+	self._blocksShared = (self._blocks ~= nil)
 	Store.pushCondition(self, _EMPTY)
 
 	return snapshot
@@ -143,12 +609,19 @@ end
 
 
 ---
--- Roll back the store state to a previous snapshot.
+-- Roll back the store state to a previous snapshot. Like `snapshot()`, this takes the
+-- same time no matter how many blocks the store holds.
 ---
 
 function Store.rollback(self, snapshot)
+	local generation = snapshot._generation
+
 	self._conditions = table.shallowCopy(snapshot._conditions)
-	self._blocks = table.shallowCopy(snapshot._blocks)
+	self._generation = _newGeneration(generation)
+	self._blocks = generation and generation.flat
+	self._blocksShared = (self._blocks ~= nil)
+	self._currentBlock = nil
+	self._index = generation and generation.index
 end
 
 
@@ -1,3 +1,6 @@
+local Field = require('field')
+local premake = require('premake')
+local State = require('state')
 local Store = require('store')
 
 local StoreTests = test.declare('StoreTests', 'store')
@@ -5,6 +8,11 @@ local StoreTests = test.declare('StoreTests', 'store')
 
 local store
 
+local _DEFINES = Field.get('defines')
+local _KIND = Field.get('kind')
+local _PROJECTS = Field.get('projects')
+local _WORKSPACES = Field.get('workspaces')
+
 function StoreTests.setup()
 	store = Store.new()
 end
@@ -17,3 +25,316 @@ end
 function StoreTests.new_returnsObject()
 	test.isNotNil(store)
 end
+
+
+---
+-- `blocksForScopes()` should skip blocks which require a different scope value.
+---
+
+local function _addProjectBlocks()
+	store:addValue(_DEFINES, 'GLOBAL')
+	store:pushCondition({ workspaces = 'Workspace1' })
+	store:addValue(_DEFINES, 'WKS1')
+	store:pushCondition({ projects = 'Project1' })
+	store:addValue(_DEFINES, 'PRJ1')
+	store:popCondition()
+	store:pushCondition({ projects = 'Project2' })
+	store:addValue(_DEFINES, 'PRJ2')
+	store:popCondition()
+	store:popCondition()
+end
+
+
+local function _definesOf(blocks)
+	local result = {}
+	for i = 1, #blocks do
+		table.insert(result, blocks[i].data[_DEFINES][1])
+	end
+	return result
+end
+
+
+function StoreTests.blocksForScopes_skipsOtherScopes()
+	_addProjectBlocks()
+	local blocks = store:blocksForScopes({ { [_WORKSPACES] = { 'Workspace1' }, [_PROJECTS] = { 'Project2' } } })
+	test.isEqual({ 'GLOBAL', 'WKS1', 'PRJ2' }, _definesOf(blocks))
+end
+
+
+function StoreTests.blocksForScopes_keepsStoreOrder_onMultipleScopeLists()
+	_addProjectBlocks()
+	local blocks = store:blocksForScopes({ { [_PROJECTS] = { 'Project2' } } }, { { [_PROJECTS] = { 'Project1' } } })
+	test.isEqual({ 'GLOBAL', 'PRJ1', 'PRJ2' }, _definesOf(blocks))
+end
+
+
+function StoreTests.blocksForScopes_keepsNegatedScopes()
+	store:pushCondition({ projects = 'not Project1' })
+	store:addValue(_DEFINES, 'NOT_PRJ1')
+	store:popCondition()
+	local blocks = store:blocksForScopes({ _EMPTY })
+	test.isEqual({ 'NOT_PRJ1' }, _definesOf(blocks))
+end
+
+
+function StoreTests.blocksForScopes_keepsRemoveBlocks()
+	store:pushCondition({ projects = 'Project1' })
+	store:removeValue(_DEFINES, 'GLOBAL')
+	store:popCondition()
+	local blocks = store:blocksForScopes({ _EMPTY })
+	test.isEqual({ 'GLOBAL' }, _definesOf(blocks))
+end
+
+
+function StoreTests.blocksForScopes_includesNewBlocks()
+	_addProjectBlocks()
+	store:blocksForScopes({ _EMPTY })
+	store:pushCondition({ projects = 'Project3' })
+	store:addValue(_DEFINES, 'PRJ3')
+	store:popCondition()
+	local blocks = store:blocksForScopes({ { [_PROJECTS] = { 'Project3' } } })
+	test.isEqual({ 'GLOBAL', 'PRJ3' }, _definesOf(blocks))
+end
+
+
+---
+-- `blocksWithField()` should list the blocks which set a field, in store order.
+---
+
+function StoreTests.blocksWithField_listsBlocksSettingField()
+	_addProjectBlocks()
+	store:pushCondition({ projects = 'Project1' })
+	store:addValue(_PROJECTS, 'Project1')
+	store:popCondition()
+	test.isEqual({ 1, 2, 3, 4 }, store:blocksWithField(_DEFINES))
+	test.isEqual({ 5 }, store:blocksWithField(_PROJECTS))
+end
+
+
+function StoreTests.blocksWithField_isEmpty_onUnsetField()
+	_addProjectBlocks()
+	test.isEqual({}, store:blocksWithField(_WORKSPACES))
+end
+
+
+---
+-- `testedFieldsOf()` should only list fields which some block condition tests.
+---
+
+function StoreTests.testedFieldsOf_listsOnlyTestedFields()
+	_addProjectBlocks()
+	store:pushCondition({ projects = 'Project1' })
+	store:addValue(_PROJECTS, 'Project1')
+	store:popCondition()
+	test.isEqual({}, store:testedFieldsOf(1))
+	test.isEqual({ _PROJECTS }, store:testedFieldsOf(5))
+end
+
+
+---
+-- `compact()` should reduce the number of blocks without changing query results.
+---
+
+local function _blockDefines(store)
+	local blocks = store:blocks()
+	local result = {}
+	for i = 1, #blocks do
+		result[i] = blocks[i].data[_DEFINES] or {}
+	end
+	return result
+end
+
+
+function StoreTests.compact_dropsEmptyBlocks()
+	store:pushCondition({ projects = 'Project1' })
+	store:addValue(_DEFINES, {})
+	store:popCondition()
+	store:pushCondition({ projects = 'Project2' })
+	store:addValue(_DEFINES, 'PRJ2')
+	store:popCondition()
+
+	store:compact()
+	test.isEqual({ { 'PRJ2' } }, _blockDefines(store))
+end
+
+
+function StoreTests.compact_mergesAdjacentBlocks_onSameCondition()
+	store:pushCondition({ projects = 'Project1' })
+	store:addValue(_DEFINES, 'A')
+	store:popCondition()
+	store:pushCondition({ projects = 'Project1' })
+	store:addValue(_DEFINES, 'B')
+	store:popCondition()
+
+	store:compact()
+	test.isEqual({ { 'A', 'B' } }, _blockDefines(store))
+end
+
+
+function StoreTests.compact_doesNotMerge_onTestedFieldSet()
+	store:pushCondition({ kind = 'StaticLib' })
+	store:addValue(_KIND, 'SharedLib')
+	store:popCondition()
+	store:pushCondition({ kind = 'StaticLib' })
+	store:addValue(_DEFINES, 'STATIC')
+	store:popCondition()
+
+	store:compact()
+	test.isEqual(2, #store:blocks())
+end
+
+
+function StoreTests.compact_hoistsUnconditionalBlocks_pastUnrelatedBlocks()
+	_addProjectBlocks()
+	store:addValue(_KIND, 'ConsoleApp')
+
+	store:compact()
+	test.isEqual(4, #store:blocks())
+	test.isEqual('ConsoleApp', store:blocks()[1].data[_KIND])
+end
+
+
+function StoreTests.compact_doesNotHoist_onSharedField()
+	_addProjectBlocks()
+	store:addValue(_DEFINES, 'LATE')
+
+	store:compact()
+	test.isEqual({ { 'GLOBAL' }, { 'WKS1' }, { 'PRJ1' }, { 'PRJ2' }, { 'LATE' } }, _blockDefines(store))
+end
+
+
+function StoreTests.compact_doesNotHoist_onTestedField()
+	store:addValue(_DEFINES, 'GLOBAL')
+	store:pushCondition({ kind = 'StaticLib' })
+	store:addValue(_DEFINES, 'STATIC')
+	store:popCondition()
+	store:addValue(_KIND, 'StaticLib')
+
+	store:compact()
+	test.isEqual(3, #store:blocks())
+end
+
+
+function StoreTests.compact_doesNotHoist_pastRemoveBlocks()
+	store:addValue(_DEFINES, 'GLOBAL')
+	store:pushCondition({ projects = 'Project1' })
+	store:removeValue(_DEFINES, 'GLOBAL')
+	store:popCondition()
+	store:addValue(_KIND, 'ConsoleApp')
+
+	store:compact()
+	test.isEqual(3, #store:blocks())
+end
+
+
+function StoreTests.compact_leavesSnapshotUnchanged()
+	store:addValue(_DEFINES, 'GLOBAL')
+	store:pushCondition({ projects = 'Project1' })
+	store:addValue(_DEFINES, 'PRJ1')
+	store:popCondition()
+	local snapshot = store:snapshot()
+	store:addValue(_KIND, 'ConsoleApp')
+
+	store:compact()
+	store:rollback(snapshot)
+	test.isEqual({ { 'GLOBAL' }, { 'PRJ1' } }, _blockDefines(store))
+	test.isNil(store:blocks()[1].data[_KIND])
+end
+
+
+function StoreTests.compact_keepsQueryResults()
+	_addProjectBlocks()
+	store:pushCondition({ projects = 'Project1' })
+	store:removeValue(_DEFINES, 'WKS1')
+	store:popCondition()
+	store:addValue(_DEFINES, 'LATE')
+	store:addValue(_KIND, 'ConsoleApp')
+
+	local function _query()
+		local prj = State.new(store, { workspaces = 'Workspace1', projects = 'Project1' })
+		return { prj.defines, prj.kind }
+	end
+
+	local expected = _query()
+	store:compact()
+	test.isEqual(expected, _query())
+end
+
+
+---
+-- Queries re-test earlier undecided blocks whenever a field they test changes, so a
+-- tested field can't be hoisted even if no block in between tests it.
+---
+
+function StoreTests.compact_keepsQueryResults_onFieldTestedByEarlierRemove()
+	workspace('W1', function ()
+		project('P0', function ()
+			when({ 'configurations:Debug', 'rtti:Off or On' }, function ()
+				when({ 'kind:not ConsoleApplication' }, function ()
+					removeDefines { 'A' }
+				end)
+			end)
+		end)
+	end)
+
+	rtti 'Off'
+	when({ 'files:not src/b.c' }, function ()
+		defines { 'A' }
+	end)
+	kind 'SharedLibrary'
+
+	local function _query()
+		return State.new(premake.store()):select({ workspaces = 'W1' }).defines
+	end
+
+	test.isEqual({ 'A' }, _query())
+	premake.store():compact()
+	test.isEqual({ 'A' }, _query())
+end
+
+
+---
+-- `rollback()` should return the store to the blocks it held at the snapshot, even
+-- after rolling back to other snapshots in between.
+---
+
+function StoreTests.rollback_removesLaterBlocks()
+	store:addValue(_DEFINES, 'A')
+	local snapshot = store:snapshot()
+	store:addValue(_DEFINES, 'B')
+	store:rollback(snapshot)
+	test.isEqual({ 'A' }, _definesOf(store:blocks()))
+end
+
+
+function StoreTests.rollback_restoresNewerSnapshot_afterRollingBackToOlder()
+	store:addValue(_DEFINES, 'A')
+	local older = store:snapshot()
+	store:addValue(_DEFINES, 'B')
+	local newer = store:snapshot()
+
+	store:rollback(older)
+	store:addValue(_DEFINES, 'C')
+	test.isEqual({ 'A', 'C' }, _definesOf(store:blocks()))
+
+	store:rollback(newer)
+	test.isEqual({ 'A', 'B' }, _definesOf(store:blocks()))
+
+	store:rollback(older)
+	test.isEqual({ 'A' }, _definesOf(store:blocks()))
+end
+
+
+function StoreTests.rollback_keepsIndexCurrent()
+	_addProjectBlocks()
+	local snapshot = store:snapshot()
+	store:blocksForScopes({ _EMPTY })
+
+	store:pushCondition({ projects = 'Project1' })
+	store:addValue(_DEFINES, 'PRJ1_MORE')
+	store:popCondition()
+	test.isEqual({ 'GLOBAL', 'PRJ1', 'PRJ1_MORE' }, _definesOf(store:blocksForScopes({ { [_PROJECTS] = { 'Project1' } } })))
+
+	store:rollback(snapshot)
+	test.isEqual({ 'GLOBAL', 'PRJ1' }, _definesOf(store:blocksForScopes({ { [_PROJECTS] = { 'Project1' } } })))
+end
@@ -0,0 +1,28 @@
+---
+-- Compare the 64-bit string hash against the original DJB2 hash.
+---
+
+local StringHashBench = bench.declare('StringHashBench')
+
+local _short = 'Debug|x64'
+local _long = '/home/user/projects/my-big-game/engine/source/runtime/renderer/private/deferred_shading.cpp'
+
+
+function StringHashBench.hash_short()
+	string.hash(_short)
+end
+
+
+function StringHashBench.hash64_short()
+	string.hash64(_short)
+end
+
+
+function StringHashBench.hash_long()
+	string.hash(_long)
+end
+
+
+function StringHashBench.hash64_long()
+	string.hash64(_long)
+end
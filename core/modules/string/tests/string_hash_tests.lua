@@ -0,0 +1,21 @@
+local StringHashTests = test.declare('StringHashTests', 'string')
+
+
+function StringHashTests.hash64_isEqual_onSameValue()
+	test.isEqual(string.hash64('some value'), string.hash64('some value'))
+end
+
+
+function StringHashTests.hash64_isNotEqual_onDifferentValues()
+	test.isTrue(string.hash64('some value') ~= string.hash64('some values'))
+end
+
+
+function StringHashTests.hash64_isNotEqual_onDifferentSeeds()
+	test.isTrue(string.hash64('some value', 1) ~= string.hash64('some value', 2))
+end
+
+
+function StringHashTests.hash64_handlesEmbeddedZeros()
+	test.isTrue(string.hash64('a\0b') ~= string.hash64('a\0c'))
+end
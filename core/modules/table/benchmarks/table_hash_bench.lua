@@ -0,0 +1,40 @@
+---
+-- Compare structural hashing of tables against the string serialization which
+-- would otherwise be needed to build a cache key.
+---
+
+local TableHashBench = bench.declare('TableHashBench')
+
+
+local _scopes = {
+	{ workspaces = 'Workspace1', projects = 'Project1', configurations = 'Debug', platforms = 'x86_64' },
+	{ workspaces = 'Workspace1', projects = 'Project1', configurations = 'Debug' },
+	{ workspaces = 'Workspace1', projects = 'Project1', platforms = 'x86_64' },
+	{ projects = 'Project1', configurations = 'Debug', platforms = 'x86_64' }
+}
+
+local _values = {
+	defines = { 'DEBUG', '_CRT_SECURE_NO_WARNINGS', 'UNICODE', '_UNICODE', 'WIN32_LEAN_AND_MEAN' },
+	includeDirs = { '/home/user/project/include', '/home/user/project/src', '/home/user/project/contrib/lua/src' },
+	kind = 'StaticLibrary'
+}
+
+
+function TableHashBench.hash_scopes()
+	table.hash(_scopes)
+end
+
+
+function TableHashBench.toString_scopes()
+	table.toString(_scopes)
+end
+
+
+function TableHashBench.hash_values()
+	table.hash(_values)
+end
+
+
+function TableHashBench.toString_values()
+	table.toString(_values)
+end
@@ -0,0 +1,50 @@
+local TableHashTests = test.declare('TableHashTests', 'table')
+
+
+function TableHashTests.hash_isEqual_onEqualContents()
+	test.isEqual(table.hash({ a = 1, b = { 'x', 'y' } }), table.hash({ a = 1, b = { 'x', 'y' } }))
+end
+
+
+function TableHashTests.hash_isEqual_onDifferentInsertionOrder()
+	local t1 = { a = 'A', b = 'B', c = 'C' }
+
+	local t2 = {}
+	t2.c = 'C'
+	t2.b = 'B'
+	t2.a = 'A'
+
+	test.isEqual(table.hash(t1), table.hash(t2))
+end
+
+
+function TableHashTests.hash_isNotEqual_onDifferentValues()
+	test.isTrue(table.hash({ a = 1 }) ~= table.hash({ a = 2 }))
+end
+
+
+function TableHashTests.hash_isNotEqual_onSwappedKeysAndValues()
+	test.isTrue(table.hash({ a = 'b' }) ~= table.hash({ b = 'a' }))
+end
+
+
+function TableHashTests.hash_isNotEqual_onDifferentArrayOrder()
+	test.isTrue(table.hash({ 'x', 'y' }) ~= table.hash({ 'y', 'x' }))
+end
+
+
+function TableHashTests.hash_isNotEqual_onStringVersusNumber()
+	test.isTrue(table.hash({ '1' }) ~= table.hash({ 1 }))
+end
+
+
+function TableHashTests.hash_isEqual_onIntegralFloat()
+	test.isEqual(table.hash({ 1 }), table.hash({ 1.0 }))
+end
+
+
+function TableHashTests.hash_handlesCycles()
+	local t = { a = 1 }
+	t.self = t
+	test.isNotNil(table.hash(t))
+end
@@ -0,0 +1,16 @@
+local TableNewTests = test.declare('TableNewTests', 'table')
+
+
+function TableNewTests.new_returnsEmptyTable()
+	test.isEqual({}, table.new(16, 4))
+end
+
+
+function TableNewTests.new_returnsEmptyTable_onNoSizes()
+	test.isEqual({}, table.new())
+end
+
+
+function TableNewTests.new_returnsDistinctTables()
+	test.isTrue(table.new(4) ~= table.new(4))
+end
@@ -16,3 +16,31 @@ end
 function XmlEscapeTests.escape_escapesDoubleQuotes()
 	test.isEqual('the &quot;real&quot; thing', xml.escape('the "real" thing'))
 end
+
+
+function XmlEscapeTests.escape_returnsSameValue_onNothingToEscape()
+	test.isEqual('nothing to see here', xml.escape('nothing to see here'))
+end
+
+
+function XmlEscapeTests.escape_returnsEmptyString_onNil()
+	test.isEqual('', xml.escape(nil))
+end
+
+
+function XmlEscapeTests.escape_escapesAll_onLongValues()
+	local value = string.rep('abcdefghijklmno', 20) .. '&' .. string.rep('x', 17) .. '<'
+	local expected = string.rep('abcdefghijklmno', 20) .. '&amp;' .. string.rep('x', 17) .. '&lt;'
+	test.isEqual(expected, xml.escape(value))
+end
+
+
+function XmlEscapeTests.escape_handlesValuesLongerThanMaxPath()
+	local value = string.rep('a&b', 4096)
+	test.isEqual(string.rep('a&amp;b', 4096), xml.escape(value))
+end
+
+
+function XmlEscapeTests.escape_escapesEachValue_onArray()
+	test.isEqual({ 'a &amp; b', 'c', '&lt;d&gt;' }, xml.escape({ 'a & b', 'c', '<d>' }))
+end
@@ -0,0 +1,17 @@
+commandLineOption {
+	trigger = 'bench',
+	description = 'Run the performance microbenchmarks',
+	category = 'Testing',
+	execute = function ()
+		bench = require('benchmark') -- add `bench` to global namespace
+		bench.runBenchmarks()
+	end
+}
+
+commandLineOption {
+	trigger = '--bench-only',
+	value = 'SUITE[.NAME]',
+	category = 'Testing',
+	description = 'Run only the specified benchmark suite or benchmark',
+	default = '*'
+}
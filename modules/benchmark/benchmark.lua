@@ -0,0 +1,152 @@
+---
+-- A simple microbenchmarking framework for Premake/Lua.
+--
+-- Benchmarks are declared much like unit tests, in files named `*_bench.lua`. Each
+-- function in a suite is called repeatedly until enough time has passed to get a
+-- stable measurement, and the average time per call is reported.
+---
+
+local options = require('options')
+local path = require('path')
+
+local benchmark = {}
+
+local _allowedPatterns = {}
+local _suites = {}
+
+-- Minimum amount of time, in seconds, to spend measuring each benchmark
+benchmark.minimumTime = 0.25
+
+
+function benchmark.runBenchmarks()
+	benchmark.loadAllBenchmarks()
+	benchmark.parseAllowedPatterns()
+
+	local suiteNames = table.sortedKeys(_suites)
+	for i = 1, #suiteNames do
+		local suiteName = suiteNames[i]
+		local names = benchmark.collectBenchmarksForSuite(suiteName)
+		for j = 1, #names do
+			benchmark.runIndividualBenchmark(suiteName, names[j])
+		end
+	end
+end
+
+
+function benchmark.loadAllBenchmarks()
+	local suites = os.matchFiles(path.join(_PREMAKE.MAIN_SCRIPT_DIR, '**', '*_bench.lua'))
+	for i = 1, #suites do
+		dofile(suites[i])
+	end
+end
+
+
+function benchmark.parseAllowedPatterns()
+	_allowedPatterns = {}
+
+	local patterns = string.split(options.valueOf('--bench-only'), ',')
+	for i = 1, #patterns do
+		local pattern = patterns[i]
+
+		-- if there is no '.', assume it's a suite name
+		if not string.contains(pattern, '.') then
+			pattern = pattern .. '%.*'
+		end
+
+		table.insert(_allowedPatterns, string.lower(string.patternFromWildcards(pattern)))
+	end
+end
+
+
+function benchmark.collectBenchmarksForSuite(suiteName)
+	local names = {}
+
+	local suite = _suites[suiteName]
+	local allNames = table.sortedKeys(suite)
+	for i = 1, #allNames do
+		local name = allNames[i]
+		if benchmark.isValidBenchmark(suite, name) and benchmark.isAllowedBenchmark(suiteName, name) then
+			table.insert(names, name)
+		end
+	end
+
+	return names
+end
+
+
+function benchmark.runIndividualBenchmark(suiteName, name)
+	local suite = _suites[suiteName]
+
+	if type(suite.setup) == 'function' then
+		suite.setup()
+	end
+
+	collectgarbage()
+	local secondsPerCall, iterations = benchmark.measure(suite[name])
+
+	if type(suite.teardown) == 'function' then
+		suite.teardown()
+	end
+
+	printf('%-60s %14.1f ns/op  (%d calls)', suiteName .. '.' .. name, secondsPerCall * 1e9, iterations)
+end
+
+
+---
+-- Call a function repeatedly, doubling the number of calls until the total run time
+-- exceeds `benchmark.minimumTime`.
+--
+-- @returns
+--    The average time per call, in seconds, and the number of calls made in the
+--    final measurement.
+---
+
+function benchmark.measure(fn)
+	local iterations = 1
+
+	while true do
+		local startTime = os.clock()
+		for i = 1, iterations do
+			fn()
+		end
+		local elapsedTime = os.clock() - startTime
+
+		if elapsedTime >= benchmark.minimumTime then
+			return elapsedTime / iterations, iterations
+		end
+
+		iterations = iterations * 2
+	end
+end
+
+
+function benchmark.declare(suiteName)
+	if _suites[suiteName] then
+		error(string.format('Duplicate benchmark suite `%s`', suiteName), 2)
+	end
+
+	local suite = {}
+	_suites[suiteName] = suite
+	return suite
+end
+
+
+function benchmark.isAllowedBenchmark(suiteName, name)
+	local fullName = string.lower(string.format('%s.%s', suiteName, name))
+
+	for i = 1, #_allowedPatterns do
+		if string.match(fullName, _allowedPatterns[i]) == fullName then
+			return true
+		end
+	end
+
+	return false
+end
+
+
+function benchmark.isValidBenchmark(suite, name)
+	return type(suite[name]) == 'function' and name ~= 'setup' and name ~= 'teardown'
+end
+
+
+return benchmark
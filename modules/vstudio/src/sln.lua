@@ -16,28 +16,28 @@ local sln = {}
 
 sln.elements = {}
 
-sln.elements.solution = function (wks)
+sln.elements.solution = premake.fixedElements(function (wks)
 	return {
 		sln.bom,
 		sln.header,
 		sln.projects,
 		sln.global
 	}
-end
+end)
 
-sln.elements.global = function (wks)
+sln.elements.global = premake.fixedElements(function (wks)
 	return {
 		sln.solutionConfiguration,
 		sln.projectConfiguration,
 		sln.solutionProperties
 	}
-end
+end)
 
 
 function sln.export(wks)
 	export.eol('\r\n')
 	export.indentString('\t')
-	premake.callArray(sln.elements.solution, wks)
+	premake.callElements(sln.elements.solution, wks)
 end
 
 
@@ -77,7 +77,7 @@ end
 function sln.global(wks)
 	wl('Global')
 	export.indent()
-	premake.callArray(sln.elements.global, wks)
+	premake.callElements(sln.elements.global, wks)
 	export.outdent()
 	wl('EndGlobal')
 end
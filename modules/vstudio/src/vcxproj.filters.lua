@@ -18,7 +18,7 @@ local filters = {}
 ---
 
 filters.elements = {
-	project = function (prj)
+	project = premake.fixedElements(function (prj)
 		return {
 			vcxproj.xmlDeclaration,
 			filters.project,
@@ -26,7 +26,7 @@ filters.elements = {
 			filters.filters,
 			vcxproj.endTag
 		}
-	end
+	end)
 }
 
 
@@ -43,7 +43,7 @@ function filters.export(prj)
 		return premake.export(prj, exportPath, function ()
 			export.eol('\r\n')
 			export.indentString('  ')
-			premake.callArray(filters.elements.project, prj)
+			premake.callElements(filters.elements.project, prj)
 		end)
 	end
 	return false
@@ -66,12 +66,12 @@ end
 ---
 
 function filters.identifiers(prj)
-	local settings = export.capture(function ()
+	local settings = export.captureBuffer(function ()
 		export.indent()
 		tree.traverse(prj.virtualSourceTree, {
 			onBranchEnter = function (node, depth)
 				local filename = path.getRelative(prj.baseDirectory, node.path)
-				wl('<Filter Include="%s">', path.translate(filename))
+				wl('<Filter Include="%s">', esc(path.translate(filename)))
 				export.indent()
 				wl('<UniqueIdentifier>{%s}</UniqueIdentifier>', os.uuid(node.path))
 				export.outdent()
@@ -81,9 +81,9 @@ function filters.identifiers(prj)
 		export.outdent()
 	end)
 
-	if #settings > 0 then
+	if settings ~= nil then
 		wl('<ItemGroup>')
-		wl(settings)
+		export.splice(settings)
 		wl('</ItemGroup>')
 	end
 end
@@ -115,11 +115,11 @@ function filters.emitFileItem(prj, category, filePath)
 	local virtualGroup = path.getDirectory(virtualPath)
 
 	if virtualGroup == '.' then
-		wl('<%s Include="%s" />', category.tag, path.translate(filePath))
+		wl('<%s Include="%s" />', category.tag, esc(path.translate(filePath)))
 	else
-		wl('<%s Include="%s">', category.tag, path.translate(filePath))
+		wl('<%s Include="%s">', category.tag, esc(path.translate(filePath)))
 		export.indent()
-		wl('<Filter>%s</Filter>', path.translate(virtualGroup))
+		wl('<Filter>%s</Filter>', esc(path.translate(virtualGroup)))
 		export.outdent()
 		wl('</%s>', category.tag)
 	end
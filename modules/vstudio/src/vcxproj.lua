@@ -17,11 +17,13 @@ vcxproj.RESOURCE_FILES = premake.WIN_RESOURCE_EXTENSIONS
 
 
 ---
--- Element lists describe the contents of each section of the project file
+-- Element lists describe the contents of each section of the project file. The lists
+-- below return the same elements for every object, so each is resolved once per export
+-- run and reused; see `premake.fixedElements()`.
 ---
 
 vcxproj.elements = {
-	project = function (prj)
+	project = premake.fixedElements(function (prj)
 		return {
 			vcxproj.xmlDeclaration,
 			vcxproj.project,
@@ -43,18 +45,18 @@ vcxproj.elements = {
 			vcxproj.ensureNuGetPackageBuildImports,
 			vcxproj.endTag
 		}
-	end,
+	end),
 
-	globals = function (prj)
+	globals = premake.fixedElements(function (prj)
 		return {
 			vcxproj.projectGuid,
 			vcxproj.ignoreWarnCompileDuplicatedFilename,
 			vcxproj.keyword,
 			vcxproj.rootNamespace
 		}
-	end,
+	end),
 
-	clCompile = function (cfg)
+	clCompile = premake.fixedElements(function (cfg)
 		return {
 			vcxproj.precompiledHeader,
 			vcxproj.warningLevel,
@@ -67,38 +69,38 @@ vcxproj.elements = {
 			vcxproj.minimalRebuild,
 			vcxproj.stringPooling
 		}
-	end,
+	end),
 
-	configurationPropertyGroup = function (cfg)
+	configurationPropertyGroup = premake.fixedElements(function (cfg)
 		return {
 			vcxproj.configurationType,
 			vcxproj.useDebugLibraries,
 			vcxproj.characterSet,
 			vcxproj.platformToolset
 		}
-	end,
+	end),
 
-	importExtensionSettings = function (prj)
+	importExtensionSettings = premake.fixedElements(function (prj)
 		return _EMPTY
-	end,
+	end),
 
-	itemDefinitionGroup = function (cfg)
+	itemDefinitionGroup = premake.fixedElements(function (cfg)
 		return {
 			vcxproj.clCompile,
 			vcxproj.link
 		}
-	end,
+	end),
 
-	link = function (cfg)
+	link = premake.fixedElements(function (cfg)
 		return {
 			vcxproj.subSystem,
 			vcxproj.generateDebugInformation,
 			vcxproj.enableComdatFolding,
 			vcxproj.optimizeReferences
 		}
-	end,
+	end),
 
-	outputPropertyGroup = function (cfg)
+	outputPropertyGroup = premake.fixedElements(function (cfg)
 		return {
 			vcxproj.linkIncremental,
 			vcxproj.outDir,
@@ -106,89 +108,78 @@ vcxproj.elements = {
 			vcxproj.targetName,
 			vcxproj.targetExt
 		}
-	end
+	end)
 }
 
 
 ---
 -- Source file categorizations control how each type of source object is generated.
 -- Categories are evaluated in the order in which they appear in the list.
+--
+-- Categories which can be identified by file extension should list those extensions
+-- in `extensions`; these are indexed once per export for fast lookup. Categories which
+-- need more complex logic may instead provide a `match` function, which receives the
+-- file path and returns `true` if the file belongs to the category.
 ---
 
 vcxproj.categories = {
 	{
 		tag = 'ClInclude',
-		match = function (file)
-			return string.endsWith(file, vcxproj.HEADER_FILES)
-		end
+		extensions = vcxproj.HEADER_FILES
 	},
 	{
 		tag = 'ClCompile',
-		match = function (file)
-			return string.endsWith(file, vcxproj.SOURCE_FILES)
-		end,
-		elements = function (cfg)
+		extensions = vcxproj.SOURCE_FILES,
+		elements = premake.fixedElements(function (cfg)
 			return {
 				vcxproj.clCompilePreprocessorDefinitions,
 				vcxproj.clCompileAdditionalIncludeDirectories
 			}
-		end
+		end)
 	},
 	{
 		tag = 'FxCompile',
-		match = function (file)
-			return string.endsWith(file, '.hlsl')
-		end,
-		elements = function (cfg)
+		extensions = { '.hlsl' },
+		elements = premake.fixedElements(function (cfg)
 			-- TODO: implement per-file configurations
 			return _EMPTY
-		end
+		end)
 	},
 	{
 		tag = 'ResourceCompile',
-		match = function (file)
-			return string.endsWith(file, vcxproj.RESOURCE_FILES)
-		end,
-		elements = function (cfg)
+		extensions = vcxproj.RESOURCE_FILES,
+		elements = premake.fixedElements(function (cfg)
 			-- TODO: implement per-file configurations
 			return _EMPTY
-		end
+		end)
 	},
 	{
 		tag = 'Midl',
-		match = function (file)
-			return string.endsWith(file, '.idl')
-		end,
-		elements = function (cfg)
+		extensions = { '.idl' },
+		elements = premake.fixedElements(function (cfg)
 			-- TODO: implement per-file configurations
 			return _EMPTY
-		end
+		end)
 	},
 	{
 		tag = 'Masm',
-		match = function (file)
-			return string.endsWith(file, '.asm')
-		end,
-		elements = function (cfg)
+		extensions = { '.asm' },
+		elements = premake.fixedElements(function (cfg)
 			-- TODO: implement per-file configurations
 			return _EMPTY
-		end
+		end)
 	},
 	{
 		tag = 'Image',
-		match = function (file)
-			return string.endsWith(file, '.gif', '.jpg', '.jpe', '.png', '.bmp', '.dib', '.tif', '.wmf', '.ras', '.eps', '.pcx', '.pcd', '.tga', '.dds')
-		end,
-		elements = function (cfg)
+		extensions = { '.gif', '.jpg', '.jpe', '.png', '.bmp', '.dib', '.tif', '.wmf', '.ras', '.eps', '.pcx', '.pcd', '.tga', '.dds' },
+		elements = premake.fixedElements(function (cfg)
 			-- TODO: implement per-file configurations
 			return _EMPTY
-		end
+		end)
 	},
 	{
 		tag = 'Natvis',
-		match = function (file)
-			return string.endsWith(file, '.natvis')
-		end
+		extensions = { '.natvis' }
 	},
 	{
 		tag = 'None',
@@ -247,7 +238,7 @@ function vcxproj.export(prj)
 	local didUpdateVcxproj = premake.export(prj, prj.exportPath, function ()
 		export.eol('\r\n')
 		export.indentString('  ')
-		premake.callArray(vcxproj.elements.project, prj)
+		premake.callElements(vcxproj.elements.project, prj)
 	end)
 
 	local didUpdateFilters = vstudio.vcxproj.filters.export(prj)
@@ -269,6 +260,14 @@ function vcxproj.prepare(prj)
 	local files = vcxproj.utils.collectAllSourceFiles(prj)
 	prj.categorizedSourceFiles = vcxproj.utils.categorizeSourceFiles(prj, files)
 	prj.virtualSourceTree = vcxproj.utils.buildVirtualSourceTree(prj, files)
+
+	-- Most files have no settings of their own; fetch all of them at once, per configuration
+	prj.fileConfigs = {}
+	prj.sharedFileConfigs = {}
+	for i = 1, #prj.configs do
+		prj.fileConfigs[i], prj.sharedFileConfigs[i] = vstudio.fetchFileConfigs(prj.configs[i], files)
+	end
+
 	return prj
 end
 
@@ -280,6 +279,8 @@ end
 function vcxproj.cleanup(prj)
 	prj.categorizedSourceFiles = nil
 	prj.virtualSourceTree = nil
+	prj.fileConfigs = nil
+	prj.sharedFileConfigs = nil
 end
 
 
@@ -344,7 +345,7 @@ end
 function vcxproj.globals(prj)
 	wl('<PropertyGroup Label="Globals">')
 	export.indent()
-	premake.callArray(vcxproj.elements.globals, prj)
+	premake.callElements(vcxproj.elements.globals, prj)
 	export.outdent()
 	wl('</PropertyGroup>')
 end
@@ -360,7 +361,7 @@ function vcxproj.configurationPropertyGroup(prj)
 		local cfg = prj.configs[i]
 		wl('<PropertyGroup Condition="\'$(Configuration)|$(Platform)\'==\'%s\'" Label="Configuration">', cfg.vs_build)
 		export.indent()
-		premake.callArray(vcxproj.elements.configurationPropertyGroup, cfg)
+		premake.callElements(vcxproj.elements.configurationPropertyGroup, cfg)
 		export.outdent()
 		wl('</PropertyGroup>')
 	end
@@ -375,7 +376,7 @@ end
 function vcxproj.importExtensionSettings(prj)
 	wl('<ImportGroup Label="ExtensionSettings">')
 	export.indent()
-	premake.callArray(vcxproj.elements.importExtensionSettings, prj)
+	premake.callElements(vcxproj.elements.importExtensionSettings, prj)
 	export.outdent()
 	wl('</ImportGroup>')
 end
@@ -403,7 +404,7 @@ function vcxproj.outputPropertyGroup(prj)
 		local cfg = prj.configs[i]
 		wl('<PropertyGroup Condition="\'$(Configuration)|$(Platform)\'==\'%s\'">', cfg.vs_build)
 		export.indent()
-		premake.callArray(vcxproj.elements.outputPropertyGroup, cfg)
+		premake.callElements(vcxproj.elements.outputPropertyGroup, cfg)
 		export.outdent()
 		wl('</PropertyGroup>')
 	end
@@ -415,7 +416,7 @@ function vcxproj.itemDefinitionGroup(prj)
 		local cfg = prj.configs[i]
 		wl('<ItemDefinitionGroup Condition="\'$(Configuration)|$(Platform)\'==\'%s\'">', cfg.vs_build)
 		export.indent()
-		premake.callArray(vcxproj.elements.itemDefinitionGroup, cfg)
+		premake.callElements(vcxproj.elements.itemDefinitionGroup, cfg)
 		export.outdent()
 		wl('</ItemDefinitionGroup>')
 	end
@@ -425,7 +426,7 @@ end
 function vcxproj.clCompile(cfg)
 	wl('<ClCompile>')
 	export.indent()
-	premake.callArray(vcxproj.elements.clCompile, cfg)
+	premake.callElements(vcxproj.elements.clCompile, cfg)
 	export.outdent()
 	wl('</ClCompile>')
 end
@@ -434,7 +435,7 @@ end
 function vcxproj.link(cfg)
 	wl('<Link>')
 	export.indent()
-	premake.callArray(vcxproj.elements.link, cfg)
+	premake.callElements(vcxproj.elements.link, cfg)
 	export.outdent()
 	wl('</Link>')
 end
@@ -480,7 +481,7 @@ function vcxproj.emitFileItem(prj, category, file)
 	-- If this file category supports per-file settings, drill down and fetch those. Some categories
 	-- (eg. "ClInclude", "None") don't support per-file settings; skip this step if so.
 	if category.elements ~= nil then
-		settings = export.capture(function ()
+		settings = export.captureBuffer(function ()
 			export.indent()
 
 			-- Visual Studio doesn't support project-wide per-file settings; instead each setting
@@ -495,8 +496,12 @@ function vcxproj.emitFileItem(prj, category, file)
 					wl('<ExcludedFromBuild Condition="\'$(Configuration)|$(Platform)\'==\'%s\'">true</ExcludedFromBuild>', cfg.vs_build)
 				else
 					-- fetch any scripted settings for this file and spit them out
-					local fileCfg = vstudio.fetchFileConfig(cfg, file)
-					premake.callArray(category.elements, fileCfg)
+					local fileCfg = prj.fileConfigs[i][file]
+					if fileCfg == nil then
+						fileCfg = prj.sharedFileConfigs[i]
+						fileCfg.file = file
+					end
+					premake.callElements(category.elements, fileCfg)
 				end
 			end
 
@@ -504,13 +509,13 @@ function vcxproj.emitFileItem(prj, category, file)
 		end)
 	end
 
-	file = path.translate(path.getRelative(prj.baseDirectory, file))
+	file = esc(path.translate(path.getRelative(prj.baseDirectory, file)))
 
-	if settings == nil or #settings == 0 then
+	if settings == nil then
 		wl('<%s Include="%s" />', category.tag, file)
 	else
 		wl('<%s Include="%s">', category.tag, file)
-		export.appendLine('%s', settings)
+		export.splice(settings)
 		wl('</%s>', category.tag)
 	end
 end
@@ -547,7 +552,7 @@ end
 
 function vcxproj.additionalIncludeDirectories(cfg, paths)
 	if #paths > 0 then
-		local relativePaths = path.translate(path.getRelative(cfg.project.baseDirectory, paths))
+		local relativePaths = esc(path.translate(path.getRelative(cfg.project.baseDirectory, paths)))
 		local value = string.format('%s;%%(AdditionalIncludeDirectories)', table.concat(relativePaths, ';'))
 		_element('AdditionalIncludeDirectories', cfg, value)
 	end
@@ -8,6 +8,8 @@ local vcxproj = vstudio.vcxproj
 
 local utils = {}
 
+local _categoryIndex
+
 
 ---
 -- Builds a source tree hierarchy applying any virtual paths.
@@ -63,35 +65,135 @@ end
 
 
 ---
--- Sort project source files into target tool categories, e.g. `ClCompile`, `ClInclude`. See
--- `vcxproj.categories` table in `vcxproj.lua`.
+-- Build a lookup table to quickly sort source files into categories. Categories which
+-- list their `extensions` are indexed by extension; those which supply a custom `match`
+-- function (or which list a multi-part extension like `.tar.gz`) are kept in an ordered
+-- list of matchers, to be tested as a fallback.
 --
--- @param prj
---    The project being exported.
--- @param files
---    An array containing the project's source file list.
+-- @param categories
+--    The list of categories to be indexed, e.g. `vcxproj.categories`.
 -- @returns
---    A table keyed by `vcxproj.categories` items, with each key pointing to an array of
---    absolute source file paths relevant to that category.
+--    A category index, suitable for passing to `classify()`.
 ---
 
-function utils.categorizeSourceFiles(prj, files)
-	local categorizedFiles = {}
+function utils.buildCategoryIndex(categories)
+	local index = {
+		categories = categories,
+		count = #categories,
+		byExtension = {},
+		matchers = {}
+	}
+
+	local byExtension = index.byExtension
+	local matchers = index.matchers
 
-	-- create empty lists for each category
-	local categories = vcxproj.categories
 	for ci = 1, #categories do
+		local category = categories[ci]
+
+		local extensions = category.extensions
+		if extensions ~= nil then
+			local suffixes = {}
+
+			for ei = 1, #extensions do
+				local ext = extensions[ei]
+				if path.getExtension(ext) == ext then
+					-- categories are evaluated in order; first category to claim an extension wins
+					byExtension[ext] = byExtension[ext] or ci
+				else
+					table.insert(suffixes, ext)
+				end
+			end
+
+			if #suffixes > 0 then
+				table.insert(matchers, {
+					index = ci,
+					match = function (file)
+						return string.endsWith(file, suffixes)
+					end
+				})
+			end
+		end
+
+		if category.match ~= nil then
+			table.insert(matchers, {
+				index = ci,
+				match = category.match
+			})
+		end
+	end
+
+	return index
+end
+
+
+---
+-- Returns the category index for `vcxproj.categories`, building it on first use. The
+-- index is rebuilt at the start of each export, or if the category list is replaced.
+---
+
+function utils.categoryIndex()
+	local categories = vcxproj.categories
+	if _categoryIndex == nil or _categoryIndex.categories ~= categories or _categoryIndex.count ~= #categories then
+		_categoryIndex = utils.buildCategoryIndex(categories)
+	end
+	return _categoryIndex
+end
+
+
+---
+-- Discard the cached category index, forcing it to be rebuilt on next use. Call this if
+-- `vcxproj.categories` is modified in place after an export has been run.
+---
+
+function utils.resetCategoryIndex()
+	_categoryIndex = nil
+end
+
+
+---
+-- Sort a batch of files into categories.
+--
+-- @param files
+--    An array of file paths to be categorized.
+-- @param index
+--    An optional category index, as returned by `buildCategoryIndex()`. If not provided,
+--    the index for `vcxproj.categories` is used.
+-- @returns
+--    An array, parallel to the indexed category list, with each item containing an array
+--    of files which belong to that category.
+---
+
+function utils.classify(files, index)
+	index = index or utils.categoryIndex()
+
+	local byExtension = index.byExtension
+	local matchers = index.matchers
+	local matcherCount = #matchers
+
+	local categorizedFiles = {}
+	for ci = 1, index.count do
 		categorizedFiles[ci] = {}
 	end
 
 	for fi = 1, #files do
 		local file = files[fi]
-		for ci = 1, #categories do
-			local category = categories[ci]
-			if category.match(file) then
-				table.insert(categorizedFiles[ci], file)
+
+		-- any matcher which comes before the extension's category in the list gets first crack
+		local ci = byExtension[path.getExtension(file)]
+		for mi = 1, matcherCount do
+			local matcher = matchers[mi]
+			if ci ~= nil and matcher.index >= ci then
 				break
 			end
+			if matcher.match(file) then
+				ci = matcher.index
+				break
+			end
+		end
+
+		if ci ~= nil then
+			local bucket = categorizedFiles[ci]
+			bucket[#bucket + 1] = file
 		end
 	end
 
@@ -99,4 +201,22 @@ function utils.categorizeSourceFiles(prj, files)
 end
 
 
+---
+-- Sort project source files into target tool categories, e.g. `ClCompile`, `ClInclude`. See
+-- `vcxproj.categories` table in `vcxproj.lua`.
+--
+-- @param prj
+--    The project being exported.
+-- @param files
+--    An array containing the project's source file list.
+-- @returns
+--    A table keyed by `vcxproj.categories` items, with each key pointing to an array of
+--    absolute source file paths relevant to that category.
+---
+
+function utils.categorizeSourceFiles(prj, files)
+	return utils.classify(files)
+end
+
+
 return utils
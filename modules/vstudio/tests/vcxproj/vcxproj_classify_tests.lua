@@ -0,0 +1,60 @@
+local vstudio = require('vstudio')
+
+local utils = vstudio.vcxproj.utils
+
+local VsVcxClassifyTests = test.declare('VsVcxClassifyTests', 'vcxproj', 'vstudio')
+
+
+local _categories = {
+	{
+		tag = 'Special',
+		match = function (file)
+			return string.startsWith(file, 'special')
+		end
+	},
+	{
+		tag = 'Source',
+		extensions = { '.c', '.cpp' }
+	},
+	{
+		tag = 'Archive',
+		extensions = { '.tar.gz' }
+	},
+	{
+		tag = 'Other',
+		match = function (file)
+			return true
+		end
+	}
+}
+
+local _index
+
+
+function VsVcxClassifyTests.setup()
+	_index = utils.buildCategoryIndex(_categories)
+end
+
+
+function VsVcxClassifyTests.classify_usesExtension()
+	local result = utils.classify({ 'a.c', 'b.cpp' }, _index)
+	test.isEqual({ {}, { 'a.c', 'b.cpp' }, {}, {} }, result)
+end
+
+
+function VsVcxClassifyTests.classify_prefersEarlierMatchFunction()
+	local result = utils.classify({ 'special.cpp' }, _index)
+	test.isEqual({ { 'special.cpp' }, {}, {}, {} }, result)
+end
+
+
+function VsVcxClassifyTests.classify_handlesMultiPartExtensions()
+	local result = utils.classify({ 'a.tar.gz' }, _index)
+	test.isEqual({ {}, {}, { 'a.tar.gz' }, {} }, result)
+end
+
+
+function VsVcxClassifyTests.classify_fallsBackToMatchFunction()
+	local result = utils.classify({ 'README', 'a.txt' }, _index)
+	test.isEqual({ {}, {}, {}, { 'README', 'a.txt' } }, result)
+end
@@ -1,4 +1,5 @@
 local premake = require('premake')
+local export = require('export')
 local vstudio = require('vstudio')
 
 local vcxproj = vstudio.vcxproj
@@ -75,3 +76,23 @@ function VcVcxFiltersIdentifiersTests.emitsMultipleIdentifiers_onNestedFolders()
 </ItemGroup>
 	]]
 end
+
+
+---
+-- Identifiers should follow the enclosing indentation, and folder names are written
+-- as-is rather than being treated as format strings.
+---
+
+function VcVcxFiltersIdentifiersTests.followsIndent_onNestedOutput()
+	export.indent()
+	_execute(function ()
+		files { "100%/hello.c" }
+	end)
+	test.capture [[
+	<ItemGroup>
+		<Filter Include="100%">
+			<UniqueIdentifier>{9BC0787C-87F7-790D-30E4-5F101CFAF50E}</UniqueIdentifier>
+		</Filter>
+	</ItemGroup>
+	]]
+end
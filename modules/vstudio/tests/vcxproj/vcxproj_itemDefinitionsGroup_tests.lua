@@ -5,12 +5,19 @@ local vcxproj = vstudio.vcxproj
 
 local VsVcxItemDefinitionsGroupTests = test.declare('VsVcxItemDefinitionsGroupTests', 'vcxproj', 'vstudio')
 
+local _link = vcxproj.elements.link
+
 
 function VsVcxItemDefinitionsGroupTests.setup()
 	vstudio.setTargetVersion(2015)
 end
 
 
+function VsVcxItemDefinitionsGroupTests.teardown()
+	vcxproj.elements.link = _link
+end
+
+
 local function _execute(fn)
 	workspace('MyWorkspace', function ()
 		fn()
@@ -63,3 +70,53 @@ function VsVcxItemDefinitionsGroupTests.sanityTest()
 </ItemDefinitionGroup>
 	]]
 end
+
+
+---
+-- An overridden element list may pick different elements for each configuration.
+---
+
+function VsVcxItemDefinitionsGroupTests.usesPerConfigElements_onOverriddenList()
+	vcxproj.elements.link = function (cfg)
+		if cfg.kind == 'StaticLibrary' then
+			return { vcxproj.subSystem }
+		end
+		return _link(cfg)
+	end
+
+	_execute(function ()
+		configurations { 'Debug', 'Release' }
+		when({ 'configurations:Release' }, function ()
+			kind 'StaticLibrary'
+		end)
+	end)
+
+	test.capture [[
+<ItemDefinitionGroup Condition="'$(Configuration)|$(Platform)'=='Debug|Win32'">
+	<ClCompile>
+		<PrecompiledHeader>NotUsing</PrecompiledHeader>
+		<WarningLevel>Level3</WarningLevel>
+		<DebugInformationFormat>EditAndContinue</DebugInformationFormat>
+		<Optimization>Disabled</Optimization>
+	</ClCompile>
+	<Link>
+		<SubSystem>Console</SubSystem>
+		<GenerateDebugInformation>true</GenerateDebugInformation>
+	</Link>
+</ItemDefinitionGroup>
+<ItemDefinitionGroup Condition="'$(Configuration)|$(Platform)'=='Release|Win32'">
+	<ClCompile>
+		<PrecompiledHeader>NotUsing</PrecompiledHeader>
+		<WarningLevel>Level3</WarningLevel>
+		<Optimization>MinSpace</Optimization>
+		<FunctionLevelLinking>true</FunctionLevelLinking>
+		<IntrinsicFunctions>true</IntrinsicFunctions>
+		<MinimalRebuild>false</MinimalRebuild>
+		<StringPooling>true</StringPooling>
+	</ClCompile>
+	<Link>
+		<SubSystem>Console</SubSystem>
+	</Link>
+</ItemDefinitionGroup>
+	]]
+end
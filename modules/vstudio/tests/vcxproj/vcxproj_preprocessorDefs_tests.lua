@@ -75,6 +75,33 @@ function VsVcxPreprocessorDefsTests.clCompile_perFile()
 end
 
 
+---
+-- Files without settings of their own share a configuration, but should still be
+-- listed, each under its own name.
+---
+
+function VsVcxPreprocessorDefsTests.clCompile_perFile_withSharedFiles()
+	local prj = _execute(function ()
+		files { 'hello.cpp', 'other.cpp', 'third.cpp' }
+		when({ 'files:other.cpp' }, function ()
+			defines('BETA')
+		end)
+	end)
+
+	vcxproj.files(prj)
+	test.capture [[
+<ItemGroup>
+	<ClCompile Include="hello.cpp" />
+	<ClCompile Include="other.cpp">
+		<PreprocessorDefinitions Condition="'$(Configuration)|$(Platform)'=='Debug|Win32'">BETA;%(PreprocessorDefinitions)</PreprocessorDefinitions>
+		<PreprocessorDefinitions Condition="'$(Configuration)|$(Platform)'=='Release|Win32'">BETA;%(PreprocessorDefinitions)</PreprocessorDefinitions>
+	</ClCompile>
+	<ClCompile Include="third.cpp" />
+</ItemGroup>
+	]]
+end
+
+
 ---
 -- For ClCompile, quotes should not be escaped.
 ---
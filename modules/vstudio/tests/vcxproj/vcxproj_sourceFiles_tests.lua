@@ -212,3 +212,26 @@ function VsVcxSourceFileTests.clCompile_excludedFromBuild()
 </ItemGroup>
 	]]
 end
+
+
+---
+-- Files which share their settings should still pick up settings from outer scopes,
+-- such as a negated file clause at the global scope.
+---
+
+function VsVcxSourceFileTests.clCompile_usesOuterScopeSettings_onSharedFileConfig()
+	when({ 'files:not Other.cpp' }, function ()
+		defines { 'A' }
+	end)
+	_execute(function ()
+		files { 'Hello.cpp' }
+	end)
+	test.capture [[
+<ItemGroup>
+	<ClCompile Include="Hello.cpp">
+		<PreprocessorDefinitions Condition="'$(Configuration)|$(Platform)'=='Debug|Win32'">A;%(PreprocessorDefinitions)</PreprocessorDefinitions>
+		<PreprocessorDefinitions Condition="'$(Configuration)|$(Platform)'=='Release|Win32'">A;%(PreprocessorDefinitions)</PreprocessorDefinitions>
+	</ClCompile>
+</ItemGroup>
+	]]
+end
@@ -1,4 +1,5 @@
 local dom = require('dom')
+local manifest = require('manifest')
 local path = require('path')
 local premake = require('premake')
 local State = require('state')
@@ -73,12 +74,29 @@ local _ARCHITECTURES = {
 }
 
 
+---
+-- The values read from every project configuration while exporting, which are fetched
+-- together in one pass; see `State.fetchAll()`.
+---
+
+local _PROJECT_CONFIG_FIELDS = {
+	'architecture',
+	'configurations',
+	'defines',
+	'includeDirs',
+	'platforms'
+}
+
+
 ---
 -- Visual Studio exporter entry point.
 ---
 
 function vstudio.export(version)
 	printf('Configuring...')
+	vstudio.vcxproj.utils.resetCategoryIndex()
+	premake.resetElements()
+	manifest.open(path.join(_PREMAKE.MAIN_SCRIPT_DIR, manifest.FILENAME))
 	local root = vstudio.fetch(version)
 
 	for i = 1, #root.workspaces do
@@ -87,6 +105,7 @@ function vstudio.export(version)
 		vstudio.exportWorkspace(wks)
 	end
 
+	manifest.close()
 	print('Done.')
 end
 
@@ -231,11 +250,14 @@ end
 ---
 
 function vstudio.fetchProjectConfig(prj, build, platform)
-	local cfg = vstudio.fetchConfig(prj
+	local state = prj
 		:selectAny({ configurations = build, platforms = platform })
 		:fromScopes(prj.root, prj.workspace)
 		:withInheritance()
-	)
+
+	state:fetchAll(_PROJECT_CONFIG_FIELDS)
+
+	local cfg = vstudio.fetchConfig(state)
 
 	cfg.root = prj.root
 	cfg.workspace = prj.workspace
@@ -260,11 +282,8 @@ end
 --    A `dom.Config`, with additional Visual Studio specific values.
 ---
 
-function vstudio.fetchFileConfig(cfg, file)
-	local fileCfg = dom.Config.new(cfg
-		:select({ files = file })
-		:fromScopes(cfg.root, cfg.workspace, cfg.project)
-	)
+local function _newFileConfig(cfg, state, file)
+	local fileCfg = dom.Config.new(state:fromScopes(cfg.root, cfg.workspace, cfg.project))
 
 	fileCfg.file = file
 	fileCfg.project = cfg.project
@@ -274,6 +293,42 @@ function vstudio.fetchFileConfig(cfg, file)
 end
 
 
+function vstudio.fetchFileConfig(cfg, file)
+	return _newFileConfig(cfg, cfg:select({ files = file }), file)
+end
+
+
+---
+-- Fetch the settings for many files at once; see `State.selectEach()`.
+--
+-- @param cfg
+--    The `dom.Config` instance which contains the target file settings.
+-- @param files
+--    The list of file paths for which settings should be fetched.
+-- @returns
+--    A table mapping each file with settings of its own to its `dom.Config`, and a single
+--    `dom.Config` shared by all of the other files, or `nil` if there are none. The shared
+--    configuration's `file` is that of the first file to share it; callers should set it
+--    to the file at hand before use.
+---
+
+function vstudio.fetchFileConfigs(cfg, files)
+	local states, shared, sharedFile = cfg:selectEach('files', files)
+
+	local fileCfgs = {}
+	for file, state in pairs(states) do
+		fileCfgs[file] = _newFileConfig(cfg, state, file)
+	end
+
+	local sharedCfg
+	if shared ~= nil then
+		sharedCfg = _newFileConfig(cfg, shared, sharedFile)
+	end
+
+	return fileCfgs, sharedCfg
+end
+
+
 ---
 -- Helper for `vstudio.fetchWorkspaceConfig()` and `vstudio.fetchProjectConfig()`.
 -- Computes common Visual Studio specific values required by the exporter.
@@ -305,7 +360,12 @@ end
 ---
 
 function vstudio.exportWorkspace(wks)
-	premake.export(wks, wks.exportPath, vstudio.sln.export)
+	local fingerprint = manifest.fingerprint({ workspaces = wks.name }, 'sln', vstudio.targetVersion)
+	if not manifest.isCurrent(wks.exportPath, fingerprint) then
+		premake.export(wks, wks.exportPath, vstudio.sln.export)
+		manifest.record(wks.exportPath, fingerprint, { wks.exportPath })
+	end
+
 	for i = 1, #wks.projects do
 		vstudio.exportProject(wks.projects[i])
 	end
@@ -314,11 +374,19 @@ end
 
 ---
 -- Export a Visual Studio project (`.vcxproj`, `.vsproj`, etc.) to the file system.
+-- Skipped if the export manifest shows that neither the project's inputs nor its
+-- files on disk have changed since it was last exported.
 ---
 
 function vstudio.exportProject(prj)
+	local fingerprint = manifest.fingerprint({ workspaces = prj.workspace.name, projects = prj.name }, 'vcxproj', vstudio.targetVersion)
+	if manifest.isCurrent(prj.exportPath, fingerprint) then
+		return
+	end
+
 	-- TODO: branch by project type; only supporting .vcxproj at the moment
 	vstudio.vcxproj.export(prj)
+	manifest.record(prj.exportPath, fingerprint, { prj.exportPath, prj.exportPath .. '.filters' })
 end
 
 
@@ -3,6 +3,7 @@
 -- Use this script to configure the project with Premake6.
 ---
 
+register('benchmark')
 register('testing')
 
 workspace('Premake', function ()